@@ -4,6 +4,7 @@
 #include "core/hex_mesh.h"
 #include "core/mesh.h"
 #include "core/pent_mesh.h"
+#include "core/tesselation_cache.h"
 #include "honeycomb/honeycomb.h"
 #include "honeycomb/honeycomb_cell.h"
 #include "honeycomb/honeycomb_honey.h"
@@ -16,6 +17,7 @@
 #include "ridge_based_polyhedron.h"
 #include "ridge_impl/ridge_hex_grid.h"
 #include "ridge_impl/ridge_mesh.h"
+#include "ridge_impl/streaming_terrain.h"
 #include "src/tal/godot_core.h"
 
 /**
@@ -58,6 +60,8 @@ void initialize_Sota_module(ModuleInitializationLevel p_level) {
   GDREGISTER_ABSTRACT_CLASS(sota::RidgeHexGrid);
   GDREGISTER_CLASS(sota::RectRidgeHexGrid);
   GDREGISTER_CLASS(sota::HexagonalRidgeHexGrid);
+  GDREGISTER_ABSTRACT_CLASS(sota::TerrainRegion);  // NOT ABSTRACT, see comment to `initialize_Sota_module`
+  GDREGISTER_CLASS(sota::StreamingTerrain);
 
   // Grids made of pairs of hexes
   GDREGISTER_ABSTRACT_CLASS(sota::Honeycomb);
@@ -76,6 +80,8 @@ void uninitialize_Sota_module(ModuleInitializationLevel p_level) {
   if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
     return;
   }
+  // templates hold engine arrays, release them while engine is alive
+  sota::TesselationCache::instance().clear();
 }
 
 #ifdef SOTA_GDEXTENSION
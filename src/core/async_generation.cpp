@@ -0,0 +1,66 @@
+#include "core/async_generation.h"
+
+#include <atomic>      // for atomic
+#include <functional>  // for function
+#include <thread>      // for thread
+#include <utility>     // for move, pair
+#include <vector>      // for vector
+
+#include "tal/godot_core.h"  // for Variant
+#include "tal/object.h"      // for Object
+
+namespace sota {
+
+AsyncGeneration::~AsyncGeneration() { cancel(); }
+
+void AsyncGeneration::start(Object& owner, std::function<void()> generate) {
+  _owner = &owner;
+  _running = true;
+  _thread = std::thread([this, generate = std::move(generate)]() {
+    generate();
+    // deferred calls are thread safe
+    _owner->call_deferred("finish_generation");
+  });
+}
+
+bool AsyncGeneration::finish(const std::function<void()>& publish) {
+  if (!is_running()) {
+    return false;
+  }
+  _thread.join();
+  _running = false;
+  publish();
+  std::vector<std::pair<const char*, Variant>> calls = std::move(_queued_calls);
+  _queued_calls.clear();
+  for (const auto& [setter, value] : calls) {
+    _owner->call(setter, value);
+  }
+  return true;
+}
+
+void AsyncGeneration::cancel() {
+  if (!is_running()) {
+    return;
+  }
+  _cancelled = true;
+  _thread.join();
+  _cancelled = false;
+  _running = false;
+  _queued_calls.clear();
+}
+
+void AsyncGeneration::report_progress(float ratio) const {
+  if (is_running()) {
+    _owner->call_deferred("emit_signal", "progress", ratio);
+  }
+}
+
+bool AsyncGeneration::queue_call(const char* setter, const Variant& value) {
+  if (!is_running()) {
+    return false;
+  }
+  _queued_calls.emplace_back(setter, value);
+  return true;
+}
+
+}  // namespace sota
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>      // for atomic
+#include <functional>  // for function
+#include <thread>      // for thread
+#include <utility>     // for pair
+#include <vector>      // for vector
+
+#include "tal/godot_core.h"  // for Variant
+#include "tal/object.h"      // for Object
+
+namespace sota {
+
+/**
+ * @brief Runs generation of terrain on background thread. Background thread only calculates tiles and their meshes:
+ * nodes are created and meshes are uploaded by owner on the main thread once generation is finished, so old terrain
+ * stays visible until then and is replaced in one frame
+ *
+ * Properties of owner are read by background thread, so their setters are queued while generation is running, see
+ * queue_call(). Resources assigned to properties (noises, shaders, textures) must not be edited meanwhile. Owner binds
+ * "finish_generation" method calling finish() and declares "progress" and "finished" signals
+ */
+class AsyncGeneration {
+ public:
+  AsyncGeneration() = default;
+  AsyncGeneration(const AsyncGeneration& other) = delete;
+  AsyncGeneration& operator=(const AsyncGeneration& other) = delete;
+  ~AsyncGeneration();
+
+  /**
+   * @brief Runs generate on background thread, "finish_generation" of owner is called on the main thread afterwards
+   */
+  void start(Object& owner, std::function<void()> generate);
+
+  /**
+   * @brief Waits for background thread and calls publish, which shows generated tiles. Setters queued meanwhile are
+   * called afterwards in order
+   *
+   * @return whether generation was running, otherwise nothing is published
+   */
+  bool finish(const std::function<void()>& publish);
+
+  /**
+   * @brief Asks background thread to stop, waits for it and drops queued setters. Called before owner is deleted
+   */
+  void cancel();
+
+  /**
+   * @brief Whether cancel() waits for background thread. Generation checks it between stages and returns early
+   */
+  bool is_cancelled() const { return _cancelled; }
+
+  /**
+   * @brief Emits "progress" signal of owner on the main thread. Does nothing unless generation is running
+   */
+  void report_progress(float ratio) const;
+
+  /**
+   * @brief Queues call of setter of owner with value if generation is running, it's called by finish()
+   *
+   * @return whether call is queued, setter returns without changing property then
+   */
+  bool queue_call(const char* setter, const Variant& value);
+
+  bool is_running() const { return _running; }
+
+ private:
+  Object* _owner{nullptr};
+  bool _running{false};
+  std::atomic<bool> _cancelled{false};
+  std::thread _thread;
+  // setters are string literals
+  std::vector<std::pair<const char*, Variant>> _queued_calls;
+};
+
+}  // namespace sota
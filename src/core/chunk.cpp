@@ -0,0 +1,195 @@
+#include "core/chunk.h"
+
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "core/mesh.h"             // for SotaMesh, MeshAttribute
+#include "core/surface_regions.h"  // for SurfaceRegions
+#include "tal/arrays.h"            // for Array, Dictionary, Vector3Array, FloatArray
+#include "tal/engine.h"            // for EditorInterface
+#include "tal/material.h"          // for Material
+#include "tal/mesh.h"              // for ArrayMesh, MeshInstance3D
+#include "tal/rendering_server.h"  // for RenderingServer, AABB
+#include "tal/vector2.h"           // for Vector2
+#include "tal/vector3.h"           // for Vector3
+
+namespace sota {
+
+Chunk::Chunk(std::vector<Ref<SotaMesh>> meshes, Node3D* parent) : _meshes(std::move(meshes)) {
+  _mesh.instantiate();
+  _mesh_instance = memnew(MeshInstance3D());
+  _mesh_instance->set_mesh(_mesh);
+  add_child(_mesh_instance);
+  parent->add_child(this);
+#ifdef SOTA_ENGINE
+  _mesh_instance->set_owner(EditorInterface::get_singleton()->get_edited_scene_root());
+#endif
+
+  for (int i = 0; i < static_cast<int>(_meshes.size()); ++i) {
+    _meshes[i]->set_chunk(this, i);
+  }
+  rebuild();
+}
+
+Chunk::~Chunk() {
+  for (Ref<SotaMesh>& mesh : _meshes) {
+    mesh->set_chunk(nullptr, 0);
+    // own surface of mesh wasn't updated while it was a part of chunk
+    mesh->_surface_layout_changed = true;
+  }
+}
+
+void Chunk::rebuild() {
+  _mesh->clear_surfaces();
+  _surfaces.clear();
+  _tile_surface.assign(_meshes.size(), {-1, 0});
+  _tile_aabb.assign(_meshes.size(), AABB());
+
+  for (int t = 0; t < static_cast<int>(_meshes.size()); ++t) {
+    SotaMesh& mesh = *_meshes[t].ptr();
+    mesh.recalculate_dirty();
+    mesh._surface_layout_changed = false;
+    if (mesh.vertices_.is_empty()) {
+      continue;
+    }
+    _tile_aabb[t] = mesh.calculate_aabb();
+    Ref<Material> material = mesh.get_material();
+    int s = 0;
+    while (s < static_cast<int>(_surfaces.size()) && _surfaces[s].material.ptr() != material.ptr()) {
+      ++s;
+    }
+    if (s == static_cast<int>(_surfaces.size())) {
+      _surfaces.push_back(Surface{.material = material});
+    }
+    _tile_surface[t] = {s, static_cast<int>(_surfaces[s].tiles.size())};
+    _surfaces[s].tiles.push_back(t);
+  }
+
+  for (Surface& surface : _surfaces) {
+    add_surface(surface);
+  }
+  update_aabb();
+}
+
+void Chunk::add_surface(Surface& surface) {
+  const SotaMesh& front = *_meshes[surface.tiles.front()].ptr();
+  bool has_normals = front.has_attribute(MeshAttribute::Normal);
+  bool has_tex_uv = front.has_attribute(MeshAttribute::TexUV);
+
+  int vertices_count = 0;
+  int indices_count = 0;
+  for (int t : surface.tiles) {
+    surface.first_vertex.push_back(vertices_count);
+    vertices_count += _meshes[t]->vertices_.size();
+    indices_count += _meshes[t]->indices_.size();
+  }
+  surface.first_vertex.push_back(vertices_count);
+
+  Vector3Array vertices;
+  Vector3Array normals;
+  Vector2Array tex_uv;
+  IntArray indices;
+  FloatArray ids;
+  vertices.resize(vertices_count);
+  normals.resize(has_normals ? vertices_count : 0);
+  tex_uv.resize(has_tex_uv ? vertices_count : 0);
+  indices.resize(indices_count);
+  ids.resize(vertices_count);
+
+  Vector3* v = vertices.ptrw();
+  Vector3* n = normals.ptrw();
+  Vector2* uv = tex_uv.ptrw();
+  int* idx = indices.ptrw();
+  float* id = ids.ptrw();
+  for (int k = 0; k < static_cast<int>(surface.tiles.size()); ++k) {
+    const SotaMesh& mesh = *_meshes[surface.tiles[k]].ptr();
+    int first = surface.first_vertex[k];
+    int count = mesh.vertices_.size();
+    const Vector3* tile_vertices = mesh.vertices_.ptr();
+    const Vector3* tile_normals = mesh.normals_.ptr();
+    const Vector2* tile_tex_uv = mesh.tex_uv1_.ptr();
+    for (int i = 0; i < count; ++i) {
+      v[first + i] = tile_vertices[i];
+      if (has_normals) {
+        n[first + i] = tile_normals[i];
+      }
+      if (has_tex_uv) {
+        uv[first + i] = tile_tex_uv[i];
+      }
+      id[first + i] = mesh.get_id();
+    }
+    const int* tile_indices = mesh.indices_.ptr();
+    for (int i = 0; i < mesh.indices_.size(); ++i) {
+      *idx++ = first + tile_indices[i];
+    }
+  }
+
+  Array arrays;
+  arrays.resize(ArrayMesh::ARRAY_MAX);
+  arrays[ArrayMesh::ARRAY_VERTEX] = vertices;
+  if (has_normals) {
+    arrays[ArrayMesh::ARRAY_NORMAL] = normals;
+  }
+  if (has_tex_uv) {
+    arrays[ArrayMesh::ARRAY_TEX_UV] = tex_uv;
+  }
+  arrays[ArrayMesh::ARRAY_CUSTOM0] = ids;
+  arrays[ArrayMesh::ARRAY_INDEX] = indices;
+  _mesh->add_surface_from_arrays(ArrayMesh::PRIMITIVE_TRIANGLES, arrays, TypedArray<Array>(), Dictionary(),
+                                 ArrayMesh::ARRAY_CUSTOM_R_FLOAT << ArrayMesh::ARRAY_FORMAT_CUSTOM0_SHIFT);
+  _mesh->surface_set_material(_mesh->get_surface_count() - 1, surface.material);
+
+  surface.format = RenderingServer::ARRAY_FORMAT_VERTEX | RenderingServer::ARRAY_FORMAT_INDEX |
+                   RenderingServer::ARRAY_FORMAT_CUSTOM0 |
+                   (RenderingServer::ARRAY_CUSTOM_R_FLOAT << RenderingServer::ARRAY_FORMAT_CUSTOM0_SHIFT);
+  if (has_normals) {
+    surface.format |= RenderingServer::ARRAY_FORMAT_NORMAL;
+  }
+  if (has_tex_uv) {
+    surface.format |= RenderingServer::ARRAY_FORMAT_TEX_UV;
+  }
+}
+
+void Chunk::update_tile(int index) {
+  SotaMesh& mesh = *_meshes[index].ptr();
+  auto [s, k] = _tile_surface[index];
+  if (s < 0 || mesh._surface_layout_changed) {
+    rebuild();
+    return;
+  }
+  const Surface& surface = _surfaces[s];
+  int first = surface.first_vertex[k];
+  int count = surface.first_vertex[k + 1] - first;
+  if (mesh.vertices_.size() != count) {
+    rebuild();
+    return;
+  }
+
+  SurfaceRegions regions(_mesh->get_rid(), surface.format, surface.first_vertex.back(), s);
+  regions.update_vertices(first, count, mesh.vertices_.ptr(),
+                          (surface.format & RenderingServer::ARRAY_FORMAT_NORMAL) ? mesh.normals_.ptr() : nullptr);
+  if (surface.format & RenderingServer::ARRAY_FORMAT_TEX_UV) {
+    // UVs are interleaved with ids in attribute buffer
+    std::vector<float> ids(count, mesh.get_id());
+    regions.update_attributes(first, count, mesh.tex_uv1_.ptr(), nullptr, ids.data());
+  }
+
+  // regions don't update bounds of surface
+  _tile_aabb[index] = mesh.calculate_aabb();
+  update_aabb();
+}
+
+void Chunk::update_aabb() {
+  bool empty = true;
+  AABB aabb;
+  for (int t = 0; t < static_cast<int>(_meshes.size()); ++t) {
+    if (_tile_surface[t].first < 0) {
+      continue;
+    }
+    aabb = empty ? _tile_aabb[t] : aabb.merge(_tile_aabb[t]);
+    empty = false;
+  }
+  _mesh->set_custom_aabb(aabb);
+}
+
+}  // namespace sota
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>  // for int64_t
+#include <utility>  // for pair
+#include <vector>   // for vector
+
+#include "core/mesh.h"             // for SotaMesh
+#include "tal/material.h"          // for Material
+#include "tal/mesh.h"              // for ArrayMesh, MeshInstance3D
+#include "tal/node.h"              // for Node3D
+#include "tal/reference.h"         // for Ref
+#include "tal/rendering_server.h"  // for AABB
+
+namespace sota {
+
+/**
+ * @brief Draws meshes of spatially close tiles as one surface per material of single MeshInstance3D, so number of nodes
+ * and draw calls doesn't grow with number of tiles
+ *
+ * Positions, normals, UVs and indices of tiles are merged, other attributes are not. Id of tile is stored in CUSTOM0
+ * attribute as single float, so shaders can tell tiles apart. Tiles of every material form their own surface
+ */
+class Chunk : public Node3D {
+ public:
+  Chunk() = delete;
+  Chunk(std::vector<Ref<SotaMesh>> meshes, Node3D* parent);
+  ~Chunk();
+
+  /**
+   * @brief Builds merged surface from scratch
+   */
+  void rebuild();
+
+  /**
+   * @brief Updates range of merged surface owned by tile. If number of vertices or indices of tile is changed, all
+   * surfaces are rebuilt
+   */
+  void update_tile(int index);
+
+  MeshInstance3D* mesh_instance() const { return _mesh_instance; }
+
+ private:
+  struct Surface {
+    Ref<Material> material;
+    // indices of tiles in order of their vertices
+    std::vector<int> tiles;
+    // first vertex of every tile, the last element is total number of vertices
+    std::vector<int> first_vertex;
+    int64_t format{0};
+  };
+
+  std::vector<Ref<SotaMesh>> _meshes;
+  std::vector<Surface> _surfaces;
+  // surface of every tile and position of tile in it, tiles without vertices have no surface
+  std::vector<std::pair<int, int>> _tile_surface;
+  // bounds of every tile, chunk is bounded by their union
+  std::vector<AABB> _tile_aabb;
+
+  Ref<ArrayMesh> _mesh;
+  MeshInstance3D* _mesh_instance{nullptr};
+
+  void add_surface(Surface& surface);
+  void update_aabb();
+};
+
+}  // namespace sota
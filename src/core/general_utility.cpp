@@ -2,42 +2,74 @@
 
 #include <cmath>       // for lerp
 #include <functional>  // for function
-#include <optional>
-
-#include "core/utils.h"          // for epsilonEqual
-#include "misc/discretizer.h"    // for Discretizer
-#include "misc/types.h"          // for GroupedMeshVer...
-#include "misc/utilities.h"      // for to_point_divis...
-#include "primitives/polygon.h"  // for RegularPolygon
-#include "ridge_impl/ridge.h"    // for Ridge
-#include "tal/arrays.h"          // for Vector3Array
+#include <limits>      // for numeric_limits
+#include <map>         // for map
+#include <utility>     // for pair
+#include <vector>      // for vector
+
+#include "core/noise_cache.h"        // for NoiseCache
+#include "core/utils.h"              // for epsilonEqual
+#include "misc/discretizer.h"        // for Discretizer
+#include "misc/types.h"              // for GroupedMeshVer...
+#include "misc/utilities.h"          // for to_point_divis...
+#include "primitives/polygon.h"      // for RegularPolygon
+#include "ridge_impl/ridge.h"        // for Ridge
+#include "ridge_impl/ridge_index.h"  // for RidgeIndex
+#include "tal/arrays.h"              // for Vector3Array
 #include "tal/godot_core.h"
-#include "tal/noise.h"      // for FastNoiseLite
-#include "tal/reference.h"  // for Ref
-#include "tal/vector2.h"    // for Vector2
-#include "tal/vector3.h"    // for Vector3
+#include "tal/vector2.h"  // for Vector2
+#include "tal/vector3.h"  // for Vector3
 
 namespace sota {
 
-void GeneralUtility::make_smooth_normals(std::vector<DiscreteVertexToNormals>& vertex_groups) {
-  DiscreteVertexToNormals all;
-  for (auto& g : vertex_groups) {
-    for (auto it = g.begin(); it != g.end(); ++it) {
-      all[it->first].insert(all[it->first].end(), it->second.begin(), it->second.end());
+namespace {
+
+// closest point of ridges, the first ridge wins if several are equally close. Coordinates are max if there are no
+// ridges
+Vector3 closest_ridge_point(const std::vector<const Ridge*>& ridges, Vector3 p, bool flat) {
+  constexpr float max = std::numeric_limits<float>::max();
+  Vector3 res(max, max, max);
+  float best_distance = max;
+  for (const Ridge* ridge : ridges) {
+    Vector3 point = ridge->closest_point(p, flat);
+    float distance = flat ? Vector2(p.x, p.z).distance_to(Vector2(point.x, point.z)) : p.distance_to(point);
+    if (distance < best_distance) {
+      res = point;
+      best_distance = distance;
+    }
+  }
+  return res;
+}
+
+}  // namespace
+
+void GeneralUtility::make_smooth_normals(const std::vector<DiscreteVertexToNormals>& vertex_groups,
+                                        const std::vector<Vector3Array*>& normals) {
+  // normals are addressed by mesh and vertex, pointers into arrays are taken only for writing
+  std::map<DiscreteVertex, std::vector<std::pair<int, int>>> all;
+  int meshes_count = vertex_groups.size();
+  for (int mesh = 0; mesh < meshes_count; ++mesh) {
+    for (const auto& [vertex, indices] : vertex_groups[mesh]) {
+      for (int i : indices) {
+        all[vertex].emplace_back(mesh, i);
+      }
     }
   }
 
-  for (auto it = all.begin(); it != all.end(); ++it) {
-    auto& series_of_normals = it->second;
+  std::vector<Vector3*> targets;
+  for (Vector3Array* n : normals) {
+    targets.push_back(n->ptrw());
+  }
+  for (const auto& [vertex, series_of_normals] : all) {
     Vector3 normal(0.0, 0.0, 0.0);
-    for (auto* n : series_of_normals) {
-      normal += *n;
+    for (auto [mesh, i] : series_of_normals) {
+      normal += targets[mesh][i];
     }
 
     normal /= series_of_normals.size();
     normal.normalize();
-    for (auto* n : series_of_normals) {
-      *n = normal;
+    for (auto [mesh, i] : series_of_normals) {
+      targets[mesh][i] = normal;
     }
   }
 }
@@ -67,76 +99,54 @@ PointToLineDistance_EquationBased::get_border_line_coeffs(float R, float r, std:
 }
 
 // FlatMeshProcessor definitions
-Vector3Array FlatMeshProcessor::shift_compress(Vector3Array vertices, float shift, float compress, float offset) {
-  Vector3Array result;
-  int n = vertices.size();
-  for (int i = 0; i < n; ++i) {
-    Vector3 p = vertices[i];
+void FlatMeshProcessor::shift_compress(std::span<Vector3> vertices, float shift, float compress, float offset) {
+  for (auto& p : vertices) {
     p.y += shift;
     p.y *= compress;
     p.y += offset;
-    result.push_back(p);
   }
-  return result;
 }
-void FlatMeshProcessor::calculate_initial_heights(Vector3Array& vertices, Ref<FastNoiseLite> noise, float& min_height,
-                                                  float& max_height, Vector3 normal) {
+void FlatMeshProcessor::calculate_initial_heights(std::span<Vector3> vertices, const NoiseCache& noise,
+                                                  float& min_height, float& max_height, Vector3 normal) {
   for (auto& v : vertices) {
-    float n = noise.ptr() ? noise->get_noise_2d(v.x, v.z) : 0.0;
+    float n = noise.get(v);
     v += n * normal;
     min_height = std::min(min_height, v.y);
     max_height = std::max(max_height, v.y);
   }
 }
-void FlatMeshProcessor::calculate_hill_heights(Vector3Array& vertices, float r, float R, Vector3 center) {
+void FlatMeshProcessor::calculate_hill_heights(std::span<Vector3> vertices, float r, float R, Vector3 center) {
   auto t = [r, this](float dist_to_center_axis) -> float { return (r - std::min(r, dist_to_center_axis)) / r; };
   for (auto& v : vertices) {
     v.y *= std::lerp(1.0f, 3.0f, t(Vector2(0, 0).distance_to(Vector2(v.x, v.z))));
   }
 }
 
-Vector3Array FlatMeshProcessor::calculate_ridge_based_heights(
-    Vector3Array vertices, const RegularPolygon& base, const std::vector<Ridge*> ridges,
+void FlatMeshProcessor::calculate_ridge_based_heights(
+    std::span<Vector3> vertices, const RegularPolygon& base, const RidgeIndex& ridges,
     std::vector<Vector3> neighbours_corner_points, float R, std::set<int> exclude_border_set, float diameter,
-    int divisions, DiscreteVertexToDistance& distance_map, Ref<FastNoiseLite> ridge_noise, float ridge_offset,
+    int divisions, const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise, float ridge_offset,
     std::function<double(double, double, double)> interpolation_func, float& min_height, float& max_height) {
   auto divisioned = [diameter, divisions](Vector3 point) {
     return VertexToNormalDiscretizer::get_discrete_vertex(point, diameter / (divisions * 2));
   };
-  Vector3Array result;
-  for (int i = 0; i < vertices.size(); ++i) {
-    Vector3 v = vertices[i];
-    auto center = base.center();
-    std::vector<Vector3> ridge_points;
-    for (const Ridge* ridge : ridges) {
-      if (ridge->start().distance_to(center) < 2 * R || ridge->end().distance_to(center) < 2 * R) {
-        auto p = ridge->get_points();
-        ridge_points.insert(ridge_points.end(), p.begin(), p.end());
-      }
-    }
+  auto center = base.center();
+  std::vector<const Ridge*> near_ridges = ridges.ridges_near(center, 2 * R);
 
+  for (auto& v : vertices) {
     PointToLineDistance_VectorMultBased calculator(exclude_border_set, base.points());
     float distance_to_border = calculator.calc(Vector3(v.x, 0, v.z));
     for (const auto& point : neighbours_corner_points) {
       distance_to_border = std::min(distance_to_border, Vector2(v.x, v.z).distance_to(Vector2(point.x, point.z)) +
-                                                            distance_map[divisioned(point)]);
+                                                            find_distance(distance_map, divisioned(point)));
     }
-    auto closestRidgePoint = [ridge_points](Vector2 p) -> Vector3 {
-      auto it = std::min_element(ridge_points.begin(), ridge_points.end(), [p](Vector3 lhs, Vector3 rhs) {
-        return p.distance_to(Vector2(lhs.x, lhs.z)) < p.distance_to(Vector2(rhs.x, rhs.z));
-      });
-      return it != ridge_points.end() ? *it
-                                      : Vector3{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
-                                                std::numeric_limits<float>::max()};
-    };
-
-    Vector3 crp = closestRidgePoint(Vector2(v.x, v.z));
+    Vector3 crp = closest_ridge_point(near_ridges, v, true);
 
     float distance_to_ridge_projection = Vector2(crp.x, crp.z).distance_to(Vector2(v.x, v.z));
     float approx_end = crp.y;
     auto t = [](float to_border, float to_projection) { return to_border / (to_border + to_projection); };
 
-    float n = ridge_noise.ptr() ? std::abs(ridge_noise->get_noise_2d(v.x, v.z)) * 0.289 : 0;
+    float n = std::abs(ridge_noise.get(v)) * 0.289;
     auto t_perlin = [distance_to_border, ridge_offset](float y) -> float {
       if (epsilonEqual(distance_to_border, 0.0f)) {
         return 0.0f;
@@ -148,31 +158,25 @@ Vector3Array FlatMeshProcessor::calculate_ridge_based_heights(
 
     min_height = std::min(min_height, v.y);
     max_height = std::max(max_height, v.y);
-
-    result.push_back(v);
   }
-
-  return result;
 }
 
 // VolumeMeshProcessor definitions
-Vector3Array VolumeMeshProcessor::shift_compress(Vector3Array vertices, float shift, float compress, float offset) {
-  Vector3Array result;
+void VolumeMeshProcessor::shift_compress(std::span<Vector3> vertices, float shift, float compress, float offset) {
   int n = vertices.size();
   for (int i = 0; i < n; ++i) {
     Vector3 dir = _initial_vertices[i].normalized();
-    result.push_back(_initial_vertices[i] + dir * (vertices[i].length() - _initial_vertices[i].length()) * compress);
+    vertices[i] = _initial_vertices[i] + dir * (vertices[i].length() - _initial_vertices[i].length()) * compress;
   }
-  return result;
 }
 
-void VolumeMeshProcessor::calculate_initial_heights(Vector3Array& vertices, Ref<FastNoiseLite> noise, float& min_height,
-                                                    float& max_height, Vector3 normal) {
+void VolumeMeshProcessor::calculate_initial_heights(std::span<Vector3> vertices, const NoiseCache& noise,
+                                                    float& min_height, float& max_height, Vector3 normal) {
   for (auto& v : vertices) {
     v += v.normalized() * (1 - v.length());
   }
   for (auto& v : vertices) {
-    float n = noise.ptr() ? noise->get_noise_3d(v.x, v.y, v.z) : 0.0;
+    float n = noise.get(v);
     Vector3 old = v;
     v += n * v.normalized();
     min_height = std::min(min_height, v.length() - old.length());
@@ -180,7 +184,7 @@ void VolumeMeshProcessor::calculate_initial_heights(Vector3Array& vertices, Ref<
   }
 }
 
-void VolumeMeshProcessor::calculate_hill_heights(Vector3Array& vertices, float r, float R, Vector3 center) {
+void VolumeMeshProcessor::calculate_hill_heights(std::span<Vector3> vertices, float r, float R, Vector3 center) {
   auto t = [r](float dist_to_center_axis) -> float { return (r - std::min(r, dist_to_center_axis)) / r; };
   for (auto& v : vertices) {
     float dist_to_center_axis = center.cross(v - center).length() / center.length();
@@ -190,45 +194,32 @@ void VolumeMeshProcessor::calculate_hill_heights(Vector3Array& vertices, float r
   }
 }
 
-Vector3Array VolumeMeshProcessor::calculate_ridge_based_heights(
-    Vector3Array vertices, const RegularPolygon& base, const std::vector<Ridge*> ridges,
+void VolumeMeshProcessor::calculate_ridge_based_heights(
+    std::span<Vector3> vertices, const RegularPolygon& base, const RidgeIndex& ridges,
     std::vector<Vector3> neighbours_corner_points, float R, std::set<int> exclude_border_set, float diameter,
-    int divisions, DiscreteVertexToDistance& distance_map, Ref<FastNoiseLite> ridge_noise, float ridge_offset,
+    int divisions, const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise, float ridge_offset,
     std::function<double(double, double, double)> interpolation_func, float& min_height, float& max_height) {
   auto divisioned = [diameter, divisions](Vector3 point) {
     return VertexToNormalDiscretizer::get_discrete_vertex(point, diameter / (divisions * 2));
   };
-  Vector3Array result;
-  for (int i = 0; i < vertices.size(); ++i) {
-    Vector3 v = _initial_vertices[i];
-    auto center = base.center();
-    std::vector<Vector3> ridge_points;
-    for (const Ridge* ridge : ridges) {
-      if (ridge->start().distance_to(center) < 2 * ridge_offset ||
-          ridge->end().distance_to(center) < 2 * ridge_offset) {
-        auto p = ridge->get_points();
-        ridge_points.insert(ridge_points.end(), p.begin(), p.end());
-      }
-    }
+  auto center = base.center();
+  std::vector<const Ridge*> near_ridges = ridges.ridges_near(center, 2 * ridge_offset);
 
+  int vertices_size = vertices.size();
+  for (int i = 0; i < vertices_size; ++i) {
+    Vector3 v = _initial_vertices[i];
     PointToLineDistance_VectorMultBased calculator(exclude_border_set, base.points());
     float distance_to_border = calculator.calc(v);
     for (const auto& point : neighbours_corner_points) {
-      distance_to_border =
-          std::min(distance_to_border, (v - point.normalized()).length() + distance_map[divisioned(point)]);
+      distance_to_border = std::min(distance_to_border, (v - point.normalized()).length() +
+                                                            find_distance(distance_map, divisioned(point)));
     }
-    auto closestRidgePoint = [ridge_points](Vector3 p) -> std::optional<Vector3> {
-      auto it = std::min_element(ridge_points.begin(), ridge_points.end(),
-                                 [p](Vector3 lhs, Vector3 rhs) { return p.distance_to(lhs) < p.distance_to(rhs); });
-      return it != ridge_points.end() ? *it : std::optional<Vector3>();
-    };
-    std::optional<Vector3> crp_opt = closestRidgePoint(v);
-    if (!crp_opt) {
+    if (near_ridges.empty()) {
       printerr("Can't find closest ridge point, yield initial point");
-      result.push_back(v);
+      vertices[i] = v;
       continue;
     }
-    Vector3 crp = crp_opt.value();
+    Vector3 crp = closest_ridge_point(near_ridges, v, false);
 
     float distance_to_ridge_projection = v.cross(crp).length() / crp.length();
     Vector3 approx_end = crp;
@@ -237,13 +228,11 @@ Vector3Array VolumeMeshProcessor::calculate_ridge_based_heights(
     float length = (approx_end - v).length();
     auto t_result = t(distance_to_border, distance_to_ridge_projection);
 
-    float n = ridge_noise.ptr() ? std::abs(ridge_noise->get_noise_3dv(vertices[i])) : 0;
+    float n = std::abs(ridge_noise.get(vertices[i]));
     t_result -= std::lerp(0.0f, n, t_result);
 
     // TODO add noise
-    result.push_back(vertices[i] + t_result * direction * length);
+    vertices[i] += t_result * direction * length;
   }
-
-  return result;
 }
 }  // namespace sota
@@ -7,33 +7,37 @@
 #include <limits>      // for numeric_limits
 #include <map>         // for map
 #include <set>         // for set
+#include <span>        // for span
 #include <utility>     // for pair
 #include <vector>      // for vector
 
+#include "core/noise_cache.h"  // for NoiseCache
 #include "misc/discretizer.h"
 #include "primitives/polygon.h"
 #include "ridge_impl/ridge.h"
-#include "tal/arrays.h"     // for Vector3Array
-#include "tal/noise.h"      // for FastNoiseLite
-#include "tal/reference.h"  // for Ref
-#include "tal/vector3.h"    // for Vector3
+#include "ridge_impl/ridge_index.h"  // for RidgeIndex
+#include "tal/arrays.h"              // for Vector3Array
+#include "tal/vector3.h"             // for Vector3
 #include "tal/vector3i.h"
 
 namespace sota {
 class RegularPolygon;
 class Ridge;
 
+/**
+ * @brief Height calculations of tile. Vertices are modified in place
+ */
 class MeshProcessor {
  public:
   virtual ~MeshProcessor() = default;
-  virtual Vector3Array shift_compress(Vector3Array vertices, float shift, float compress, float offset) = 0;
-  virtual void calculate_initial_heights(Vector3Array& vertices, Ref<FastNoiseLite> noise, float& min_height,
+  virtual void shift_compress(std::span<Vector3> vertices, float shift, float compress, float offset) = 0;
+  virtual void calculate_initial_heights(std::span<Vector3> vertices, const NoiseCache& noise, float& min_height,
                                          float& max_height, Vector3 normal) = 0;
-  virtual void calculate_hill_heights(Vector3Array& vertices, float r, float R, Vector3 center) = 0;
-  virtual Vector3Array calculate_ridge_based_heights(
-      Vector3Array vertices, const RegularPolygon& base, const std::vector<Ridge*> ridges,
+  virtual void calculate_hill_heights(std::span<Vector3> vertices, float r, float R, Vector3 center) = 0;
+  virtual void calculate_ridge_based_heights(
+      std::span<Vector3> vertices, const RegularPolygon& base, const RidgeIndex& ridges,
       std::vector<Vector3> neighbours_corner_points, float R, std::set<int> exclude_border_set, float diameter,
-      int divisions, DiscreteVertexToDistance& distance_map, Ref<FastNoiseLite> ridge_noise, float ridge_offset,
+      int divisions, const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise, float ridge_offset,
       std::function<double(double, double, double)> interpolation_func, float& min_height, float& max_height) = 0;
 
  private:
@@ -41,14 +45,14 @@ class MeshProcessor {
 
 class FlatMeshProcessor : public MeshProcessor {
  public:
-  Vector3Array shift_compress(Vector3Array vertices, float shift, float compress, float offset) override;
-  void calculate_initial_heights(Vector3Array& vertices, Ref<FastNoiseLite> noise, float& min_height, float& max_height,
-                                 Vector3 normal) override;
-  void calculate_hill_heights(Vector3Array& vertices, float r, float R, Vector3 center) override;
-  Vector3Array calculate_ridge_based_heights(
-      Vector3Array vertices, const RegularPolygon& base, const std::vector<Ridge*> ridges,
+  void shift_compress(std::span<Vector3> vertices, float shift, float compress, float offset) override;
+  void calculate_initial_heights(std::span<Vector3> vertices, const NoiseCache& noise, float& min_height,
+                                 float& max_height, Vector3 normal) override;
+  void calculate_hill_heights(std::span<Vector3> vertices, float r, float R, Vector3 center) override;
+  void calculate_ridge_based_heights(
+      std::span<Vector3> vertices, const RegularPolygon& base, const RidgeIndex& ridges,
       std::vector<Vector3> neighbours_corner_points, float R, std::set<int> exclude_border_set, float diameter,
-      int divisions, DiscreteVertexToDistance& distance_map, Ref<FastNoiseLite> ridge_noise, float ridge_offset,
+      int divisions, const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise, float ridge_offset,
       std::function<double(double, double, double)> interpolation_func, float& min_height, float& max_height) override;
 
  private:
@@ -58,14 +62,14 @@ class VolumeMeshProcessor : public MeshProcessor {
  public:
   VolumeMeshProcessor(Vector3Array initial_vertices) : MeshProcessor(), _initial_vertices(initial_vertices) {}
 
-  Vector3Array shift_compress(Vector3Array vertices, float shift, float compress, float offset) override;
-  void calculate_initial_heights(Vector3Array& vertices, Ref<FastNoiseLite> noise, float& min_height, float& max_height,
-                                 Vector3 normal) override;
-  void calculate_hill_heights(Vector3Array& vertices, float r, float R, Vector3 center) override;
-  Vector3Array calculate_ridge_based_heights(
-      Vector3Array vertices, const RegularPolygon& base, const std::vector<Ridge*> ridges,
+  void shift_compress(std::span<Vector3> vertices, float shift, float compress, float offset) override;
+  void calculate_initial_heights(std::span<Vector3> vertices, const NoiseCache& noise, float& min_height,
+                                 float& max_height, Vector3 normal) override;
+  void calculate_hill_heights(std::span<Vector3> vertices, float r, float R, Vector3 center) override;
+  void calculate_ridge_based_heights(
+      std::span<Vector3> vertices, const RegularPolygon& base, const RidgeIndex& ridges,
       std::vector<Vector3> neighbours_corner_points, float R, std::set<int> exclude_border_set, float diameter,
-      int divisions, DiscreteVertexToDistance& distance_map, Ref<FastNoiseLite> ridge_noise, float ridge_offset,
+      int divisions, const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise, float ridge_offset,
       std::function<double(double, double, double)> interpolation_func, float& min_height, float& max_height) override;
 
  private:
@@ -74,7 +78,14 @@ class VolumeMeshProcessor : public MeshProcessor {
 
 class GeneralUtility {
  public:
-  static void make_smooth_normals(std::vector<DiscreteVertexToNormals>& normal_groups);
+  /**
+   * @brief Normals of coincident vertices of meshes are replaced by their average
+   *
+   * @param vertex_groups - indices of vertices of every mesh grouped by position
+   * @param normals - normals of every mesh in the same order as vertex_groups
+   */
+  static void make_smooth_normals(const std::vector<DiscreteVertexToNormals>& vertex_groups,
+                                  const std::vector<Vector3Array*>& normals);
 };
 
 /**
@@ -1,8 +1,9 @@
 #include "core/godot_utils.h"
 
-#include "tal/arrays.h"  // for TypedArray
-#include "tal/node.h"    // for Node, Node3D
-#include "tal/object.h"  // for Object
+#include "tal/arrays.h"    // for TypedArray
+#include "tal/callable.h"  // for Callable
+#include "tal/node.h"      // for Node, Node3D
+#include "tal/object.h"    // for Object
 
 namespace sota {
 
@@ -14,4 +15,13 @@ void clean_children(Node3D& parent) {
     child->queue_free();
   }
 }
+
+void reconnect_changed(Object* previous, Object* next, const Callable& callable) {
+  if (previous && previous != next && previous->is_connected("changed", callable)) {
+    previous->disconnect("changed", callable);
+  }
+  if (next && !next->is_connected("changed", callable)) {
+    next->connect("changed", callable);
+  }
+}
 }  // namespace sota
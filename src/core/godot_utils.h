@@ -1,9 +1,17 @@
 #pragma once
 
+#include "tal/callable.h"  // for Callable
 #include "tal/node.h"
+#include "tal/object.h"  // for Object
 
 namespace sota {
 
 void clean_children(Node3D& parent);
 
+/**
+ * @brief Moves callable from "changed" signal of previous resource to the one of next resource. Callable is connected
+ * only once, no matter how many times the same resource is assigned
+ */
+void reconnect_changed(Object* previous, Object* next, const Callable& callable);
+
 }  // namespace sota
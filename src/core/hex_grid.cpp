@@ -1,30 +1,53 @@
 #include "core/hex_grid.h"
 
-#include <memory>  // for allocator_traits<>:...
-
-#include "core/godot_utils.h"          // for clean_children
+#include <algorithm>  // for max, move
+#include <iterator>   // for back_inserter
+#include <map>        // for map
+#include <memory>     // for unique_ptr, make_unique
+#include <optional>   // for optional, nullopt
+#include <utility>    // for pair, move
+#include <vector>     // for vector
+
+#include "core/chunk.h"                // for Chunk
 #include "core/hex_mesh.h"             // for SimpleMesh, HexMesh...
 #include "core/hexagonal_utility.h"    // for HexagonalUtility
 #include "core/mesh.h"                 // for SotaMesh
 #include "core/rectangular_utility.h"  // for RectangularUtility
+#include "core/tile_picker.h"          // for TilePicker, TilePick
 #include "core/tile_mesh.h"            // for TileMesh
-#include "core/utils.h"                // for pointy_top_x_offset
-#include "misc/cube_coordinates.h"     // for OffsetCoordinates
+#include "core/utils.h"                // for pointy_top_x_offset, lod_divisions
+#include "misc/cube_coordinates.h"     // for OffsetCoordinates, pixelToCube, offsetToCube
 #include "misc/tile.h"                 // for Tile
 #include "misc/types.h"                // for ClipOptions
 #include "primitives/hexagon.h"        // for make_hexagon_at_pos...
 #include "tal/arrays.h"                // for Array
+#include "tal/camera.h"                // for Viewport
+#include "tal/event.h"                 // for InputEvent
 #include "tal/godot_core.h"            // for D_METHOD, ClassDB
 #include "tal/material.h"              // for ShaderMaterial
+#include "tal/mesh.h"                  // for MeshInstance3D
 #include "tal/reference.h"             // for Ref
 #include "tal/shader.h"                // for Shader
+#include "tal/transform3d.h"           // for Transform3D
 #include "tal/vector3.h"               // for Vector3
 #include "tal/vector3i.h"              // for Vector3i
 
 namespace sota {
 
+namespace {
+// tiles of block share chunk of every level of detail
+constexpr int LOD_BLOCK_SIZE = 8;
+}  // namespace
+
 void HexGrid::_bind_methods() {
   ClassDB::bind_method(D_METHOD("init"), &HexGrid::init);
+  ClassDB::bind_method(D_METHOD("request_init"), &HexGrid::request_init);
+  ClassDB::bind_method(D_METHOD("deferred_init"), &HexGrid::deferred_init);
+  ClassDB::bind_method(D_METHOD("generate_async"), &HexGrid::generate_async);
+  ClassDB::bind_method(D_METHOD("finish_generation"), &HexGrid::finish_generation);
+  ClassDB::bind_method(D_METHOD("is_generating"), &HexGrid::is_generating);
+  ADD_SIGNAL(MethodInfo("progress", PropertyInfo(Variant::FLOAT, "ratio")));
+  ADD_SIGNAL(MethodInfo("finished"));
 
   // Properties
   ClassDB::bind_method(D_METHOD("get_divisions"), &HexGrid::get_divisions);
@@ -48,39 +71,239 @@ void HexGrid::_bind_methods() {
   ClassDB::bind_method(D_METHOD("set_frame_offset", "p_frame_offset"), &HexGrid::set_frame_offset);
   ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "_frame_offset"), "set_frame_offset", "get_frame_offset");
 
+  ClassDB::bind_method(D_METHOD("get_indexed"), &HexGrid::get_indexed);
+  ClassDB::bind_method(D_METHOD("set_indexed", "p_indexed"), &HexGrid::set_indexed);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "indexed"), "set_indexed", "get_indexed");
+
+  ClassDB::bind_method(D_METHOD("get_mesh_attributes"), &HexGrid::get_mesh_attributes);
+  ClassDB::bind_method(D_METHOD("set_mesh_attributes", "p_mesh_attributes"), &HexGrid::set_mesh_attributes);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "mesh_attributes", PROPERTY_HINT_FLAGS, MESH_ATTRIBUTES_HINT),
+               "set_mesh_attributes", "get_mesh_attributes");
+
+  ClassDB::bind_method(D_METHOD("get_direct_upload"), &HexGrid::get_direct_upload);
+  ClassDB::bind_method(D_METHOD("set_direct_upload", "p_direct_upload"), &HexGrid::set_direct_upload);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "direct_upload"), "set_direct_upload", "get_direct_upload");
+
+  ClassDB::bind_method(D_METHOD("get_lod_levels"), &HexGrid::get_lod_levels);
+  ClassDB::bind_method(D_METHOD("set_lod_levels", "p_lod_levels"), &HexGrid::set_lod_levels);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_levels"), "set_lod_levels", "get_lod_levels");
+
+  ClassDB::bind_method(D_METHOD("get_lod_distance"), &HexGrid::get_lod_distance);
+  ClassDB::bind_method(D_METHOD("set_lod_distance", "p_lod_distance"), &HexGrid::set_lod_distance);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "lod_distance"), "set_lod_distance", "get_lod_distance");
+
+  ClassDB::bind_method(D_METHOD("get_chunk_size"), &HexGrid::get_chunk_size);
+  ClassDB::bind_method(D_METHOD("set_chunk_size", "p_chunk_size"), &HexGrid::set_chunk_size);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "chunk_size"), "set_chunk_size", "get_chunk_size");
+
+  ClassDB::bind_method(D_METHOD("get_analytic_picking"), &HexGrid::get_analytic_picking);
+  ClassDB::bind_method(D_METHOD("set_analytic_picking", "p_analytic_picking"), &HexGrid::set_analytic_picking);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "analytic_picking"), "set_analytic_picking", "get_analytic_picking");
+
   // API
   ClassDB::bind_method(D_METHOD("get_hex_meshes"), &HexGrid::get_hex_meshes);
+  ClassDB::bind_method(D_METHOD("pick_tile", "origin", "direction"), &HexGrid::pick_tile);
 }
 
 void HexGrid::init() {
+  if (is_generating()) {
+    _init_postponed = true;
+    return;
+  }
+  init_materials();
+  allow_reuse(true);
+  generate();
+  publish();
+}
+
+void HexGrid::init_materials() {
+  _materials.clear();
+  _materials.get(_shader, 0, [](Ref<ShaderMaterial>) {});
+}
+
+void HexGrid::generate() {
   init_col_row_layout();
   init_hexmesh();
+  index_tiles();
+  report_progress(0.5);
+  if (is_cancelled()) {
+    return;
+  }
 
   calculate_normals();
+  calculate_lods();
+}
+
+void HexGrid::publish() {
+  for (std::unique_ptr<Tile>& tile : _retired_tiles) {
+    tile->detach();
+  }
+  _retired_tiles.clear();
+  // chunks refer to meshes, which could be rebuilt
+  clear_chunks();
+  clear_lods();
+  for (std::unique_ptr<Tile>& tile : _tiles) {
+    tile->attach(this, is_batched(), !_analytic_picking);
+  }
+  init_lods();
+  init_chunks();
+}
+
+Tile* HexGrid::add_tile(std::unique_ptr<Tile> tile) {
+  _tiles.push_back(std::move(tile));
+  return _tiles.back().get();
+}
+
+void HexGrid::retire_tiles() {
+  std::move(_tiles.begin(), _tiles.end(), std::back_inserter(_retired_tiles));
+  _tiles.clear();
+  _tiles_layout.clear();
+  _tile_index.clear();
+}
+
+void HexGrid::generate_async() {
+  if (is_generating()) {
+    printerr("Generation of grid is already running");
+    return;
+  }
+  // pending requests are covered by generation
+  _init_requested = false;
+  _init_postponed = false;
+  init_materials();
+  allow_reuse(false);
+  _generation.start(*this, [this]() { generate(); });
+}
+
+void HexGrid::finish_generation() {
+  if (!_generation.finish([this]() { publish(); })) {
+    // nothing was running, e.g. call from script
+    return;
+  }
+  emit_signal("finished");
+  if (_init_postponed) {
+    _init_postponed = false;
+    init();
+  }
+}
+
+void HexGrid::_notification(int p_what) {
+  if (p_what == NOTIFICATION_PREDELETE) {
+    // background thread uses members of subclasses, which are destroyed before members of this class
+    _generation.cancel();
+  }
+}
+
+void HexGrid::request_init() {
+  if (!_init_requested) {
+    _init_requested = true;
+    call_deferred("deferred_init");
+  }
+}
+
+void HexGrid::deferred_init() {
+  if (!_init_requested) {
+    // request was covered by generate_async()
+    return;
+  }
+  _init_requested = false;
+  init();
 }
 
 void HexGrid::set_divisions(const int p_divisions) {
+  if (queue_if_generating("set_divisions", p_divisions)) {
+    return;
+  }
   _divisions = p_divisions > 1 ? p_divisions : 1;
-  init();
+  request_init();
 }
 
 void HexGrid::set_diameter(const float p_diameter) {
+  if (queue_if_generating("set_diameter", p_diameter)) {
+    return;
+  }
   _diameter = p_diameter > 0 ? p_diameter : 0;
-  init();
+  request_init();
 }
 
 void HexGrid::set_shader(const Ref<Shader> p_shader) {
+  if (queue_if_generating("set_shader", p_shader)) {
+    return;
+  }
   _shader = p_shader;
-  init();
+  request_init();
 }
 void HexGrid::set_frame_state(const bool p_state) {
+  if (queue_if_generating("set_frame_state", p_state)) {
+    return;
+  }
   _frame_state = p_state;
-  init();
+  request_init();
 }
 
 void HexGrid::set_frame_offset(const float p_offset) {
+  if (queue_if_generating("set_frame_offset", p_offset)) {
+    return;
+  }
   _frame_offset = p_offset > 0 ? p_offset : 0;
-  init();
+  request_init();
+}
+
+void HexGrid::set_indexed(const bool p_indexed) {
+  if (queue_if_generating("set_indexed", p_indexed)) {
+    return;
+  }
+  _indexed = p_indexed;
+  request_init();
+}
+
+void HexGrid::set_mesh_attributes(const int p_mesh_attributes) {
+  if (queue_if_generating("set_mesh_attributes", p_mesh_attributes)) {
+    return;
+  }
+  _mesh_attributes = p_mesh_attributes;
+  request_init();
+}
+
+void HexGrid::set_direct_upload(const bool p_direct_upload) {
+  if (queue_if_generating("set_direct_upload", p_direct_upload)) {
+    return;
+  }
+  _direct_upload = p_direct_upload;
+  request_init();
+}
+
+void HexGrid::set_lod_levels(const int p_lod_levels) {
+  if (queue_if_generating("set_lod_levels", p_lod_levels)) {
+    return;
+  }
+  _lod_levels = p_lod_levels > 1 ? p_lod_levels : 1;
+  request_init();
+}
+
+void HexGrid::set_lod_distance(const float p_lod_distance) {
+  if (queue_if_generating("set_lod_distance", p_lod_distance)) {
+    return;
+  }
+  _lod_distance = p_lod_distance > 0 ? p_lod_distance : 0;
+  // meshes of levels don't depend on distance
+  update_lod_ranges();
+}
+
+void HexGrid::set_chunk_size(const int p_chunk_size) {
+  if (queue_if_generating("set_chunk_size", p_chunk_size)) {
+    return;
+  }
+  _chunk_size = p_chunk_size > 0 ? p_chunk_size : 0;
+  request_init();
+}
+
+void HexGrid::set_analytic_picking(const bool p_analytic_picking) {
+  if (queue_if_generating("set_analytic_picking", p_analytic_picking)) {
+    return;
+  }
+  _analytic_picking = p_analytic_picking;
+  set_process_unhandled_input(_analytic_picking);
+  request_init();
 }
 
 float HexGrid::get_diameter() const { return _diameter; }
@@ -88,22 +311,34 @@ int HexGrid::get_divisions() const { return _divisions; }
 Ref<Shader> HexGrid::get_shader() const { return _shader; }
 bool HexGrid::get_frame_state() const { return _frame_state; }
 float HexGrid::get_frame_offset() const { return _frame_offset; }
+bool HexGrid::get_indexed() const { return _indexed; }
+int HexGrid::get_mesh_attributes() const { return _mesh_attributes; }
+bool HexGrid::get_direct_upload() const { return _direct_upload; }
+int HexGrid::get_lod_levels() const { return _lod_levels; }
+float HexGrid::get_lod_distance() const { return _lod_distance; }
+int HexGrid::get_chunk_size() const { return _chunk_size; }
+bool HexGrid::get_analytic_picking() const { return _analytic_picking; }
 
 void HexGrid::init_hexmesh() {
-  clean_children(*this);
+  bool reuse = can_reuse_tiles();
+  TilesLayout previous;
+  if (reuse) {
+    // tiles are changed in place, publish() shows their new meshes
+    previous = std::move(_tiles_layout);
+  } else {
+    retire_tiles();
+  }
   _tiles_layout.clear();
+  _picker.reset();
+  _tile_index.clear();
+  Ref<ShaderMaterial> mat = _materials.find(_shader, 0);
 
-  for (auto row : _col_row_layout) {
+  for (int i = 0; i < static_cast<int>(_col_row_layout.size()); ++i) {
     _tiles_layout.push_back({});
-    for (auto val : row) {
+    for (int j = 0; j < static_cast<int>(_col_row_layout[i].size()); ++j) {
+      Vector3i val = _col_row_layout[i][j];
       int id = calculate_id(val.x, val.z);
 
-      Ref<ShaderMaterial> mat;
-      mat.instantiate();
-      if (_shader.ptr()) {
-        mat->set_shader(_shader);
-      }
-
       Vector3 offset = Vector3(0, 0, 0);
       offset.x = val.z * pointy_top_x_offset(_diameter);
       offset.x += is_odd(val.x) ? pointy_top_x_offset(_diameter) / 2 : 0;
@@ -115,18 +350,212 @@ void HexGrid::init_hexmesh() {
                            .frame_offset = _frame_offset,
                            .material = mat,
                            .divisions = _divisions,
-                           .clip_options = ClipOptions{}};
+                           .clip_options = ClipOptions{},
+                           .indexed = _indexed,
+                           .attributes = _mesh_attributes,
+                           .direct_upload = _direct_upload};
       Hexagon hex = make_hexagon_at_position(offset, _diameter);
 
+      if (reuse) {
+        Tile* tile = previous[i][j];
+        dynamic_cast<SimpleMesh*>(tile->mesh().ptr())->reset(hex, params);
+        tile->reuse(tile->mesh(), offset);
+        _tiles_layout.back().push_back(tile);
+        continue;
+      }
       Ref<SimpleMesh> simple_mesh = Ref<SimpleMesh>(memnew(SimpleMesh(hex, params)));
       _tiles_layout.back().push_back(
-          make_non_ref<Tile>(simple_mesh, offset, this, OffsetCoordinates{.row = val.x, .col = val.z}));
+          add_tile(std::make_unique<Tile>(simple_mesh, offset, OffsetCoordinates{.row = val.x, .col = val.z})));
+    }
+  }
+}
+
+bool HexGrid::can_reuse_tiles() const {
+  if (!_reuse_allowed || _tiles_layout.size() != _col_row_layout.size()) {
+    return false;
+  }
+  for (int i = 0; i < static_cast<int>(_col_row_layout.size()); ++i) {
+    if (_tiles_layout[i].size() != _col_row_layout[i].size()) {
+      return false;
+    }
+    for (int j = 0; j < static_cast<int>(_col_row_layout[i].size()); ++j) {
+      const Tile* tile = _tiles_layout[i][j];
+      if (!tile->is_attached()) {
+        return false;
+      }
+      OffsetCoordinates coords = tile->get_offset_coords();
+      bool batched = tile->mesh_instance() == nullptr;
+      if (coords.row != _col_row_layout[i][j].x || coords.col != _col_row_layout[i][j].z || batched != is_batched() ||
+          tile->has_physics_body() != (!is_batched() && !_analytic_picking)) {
+        return false;
+      }
     }
   }
+  return !_tiles_layout.empty();
+}
+
+void HexGrid::calculate_lods() {
+  _lod_blocks.clear();
+  if (is_batched()) {
+    return;
+  }
+  std::vector<int> divisions = lod_divisions(_divisions, _lod_levels);
+  std::map<std::pair<int, int>, LodBlock> blocks;
+  for (std::vector<Tile*>& row : _tiles_layout) {
+    for (Tile* tile : row) {
+      std::vector<Ref<SotaMesh>> lods;
+      for (int i = 1; i < static_cast<int>(divisions.size()); ++i) {
+        Ref<SotaMesh> lod = tile->mesh()->inner_mesh()->make_lod(divisions[i]);
+        if (!lod.ptr()) {
+          break;
+        }
+        lods.push_back(lod);
+      }
+      if (lods.empty()) {
+        continue;
+      }
+      OffsetCoordinates coords = tile->get_offset_coords();
+      LodBlock& block = blocks[{coords.row / LOD_BLOCK_SIZE, coords.col / LOD_BLOCK_SIZE}];
+      block.levels.resize(std::max(block.levels.size(), lods.size()));
+      for (int i = 0; i < static_cast<int>(lods.size()); ++i) {
+        block.levels[i].push_back(lods[i]);
+      }
+      block.tiles.push_back(tile);
+    }
+  }
+  for (auto& [coords, block] : blocks) {
+    _lod_blocks.push_back(std::move(block));
+  }
+}
+
+void HexGrid::init_lods() {
+  for (std::unique_ptr<Tile>& tile : _tiles) {
+    tile->set_lod_parent(nullptr);
+  }
+  for (LodBlock& block : _lod_blocks) {
+    std::vector<MeshInstance3D*> instances;
+    _lod_chunks.resize(std::max(_lod_chunks.size(), block.levels.size()));
+    for (int i = 0; i < static_cast<int>(block.levels.size()); ++i) {
+      Chunk* chunk = memnew(Chunk(block.levels[i], this));
+      instances.push_back(chunk->mesh_instance());
+      _lod_chunks[i].push_back(chunk);
+    }
+    // level is hidden while the next one is in its visibility range, the last one is visible up to infinity
+    for (int i = 0; i + 1 < static_cast<int>(instances.size()); ++i) {
+      instances[i]->set_visibility_parent(instances[i]->get_path_to(instances[i + 1]));
+    }
+    for (Tile* tile : block.tiles) {
+      tile->set_lod_parent(instances.front());
+    }
+  }
+  update_lod_ranges();
+}
+
+void HexGrid::update_lod_ranges() {
+  for (int i = 0; i < static_cast<int>(_lod_chunks.size()); ++i) {
+    for (Chunk* chunk : _lod_chunks[i]) {
+      chunk->mesh_instance()->set_visibility_range_begin(_lod_distance * (i + 1));
+    }
+  }
+}
+
+void HexGrid::clear_lods() {
+  for (std::vector<Chunk*>& level : _lod_chunks) {
+    for (Chunk* chunk : level) {
+      chunk->get_parent()->remove_child(chunk);
+      memdelete(chunk);
+    }
+  }
+  _lod_chunks.clear();
+}
+
+void HexGrid::init_chunks() {
+  add_chunks([](Tile* tile) { return tile->mesh()->inner_mesh(); });
+}
+
+void HexGrid::add_chunks(const std::function<SotaMesh*(Tile*)>& tile_mesh) {
+  if (!is_batched()) {
+    return;
+  }
+  std::map<std::pair<int, int>, std::vector<Ref<SotaMesh>>> chunks;
+  for (std::vector<Tile*>& row : _tiles_layout) {
+    for (Tile* tile : row) {
+      OffsetCoordinates coords = tile->get_offset_coords();
+      chunks[{coords.row / _chunk_size, coords.col / _chunk_size}].push_back(Ref<SotaMesh>(tile_mesh(tile)));
+    }
+  }
+  for (auto& [block, meshes] : chunks) {
+    _chunks.push_back(memnew(Chunk(std::move(meshes), this)));
+  }
+}
+
+void HexGrid::clear_chunks() {
+  for (Chunk* chunk : _chunks) {
+    chunk->get_parent()->remove_child(chunk);
+    memdelete(chunk);
+  }
+  _chunks.clear();
+}
+
+#ifdef SOTA_GDEXTENSION
+void HexGrid::_unhandled_input(const Ref<InputEvent>& p_event) {
+#else
+void HexGrid::unhandled_input(const Ref<InputEvent>& p_event) {
+#endif
+  if (!_analytic_picking || is_generating()) {
+    return;
+  }
+  _picker.handle_input(get_viewport(), p_event,
+                       [this](Vector3 origin, Vector3 direction) { return pick(origin, direction); });
+}
+
+Ref<TileMesh> HexGrid::pick_tile(Vector3 origin, Vector3 direction) const {
+  std::optional<TilePick> picked = pick(origin, direction);
+  return picked ? Ref<TileMesh>(picked->mesh) : Ref<TileMesh>();
+}
+
+std::optional<TilePick> HexGrid::pick(Vector3 origin, Vector3 direction) const {
+  if (is_generating()) {
+    // index of tiles is being rebuilt
+    return std::nullopt;
+  }
+  Transform3D to_local = get_global_transform().affine_inverse();
+  Vector3 local_origin = to_local.xform(origin);
+  Vector3 local_direction = to_local.xform(origin + direction) - local_origin;
+  // affine transform keeps distance along ray, so it's the same in local and global space
+  std::optional<float> t = TilePicker::intersect_plane(local_origin, local_direction);
+  if (!t) {
+    return std::nullopt;
+  }
+  Vector3 hit = local_origin + local_direction * *t;
+  Tile* tile = tile_at(cubeToOffset(pixelToCube(hit.x, hit.z, _diameter / 2)));
+  if (!tile) {
+    return std::nullopt;
+  }
+  Transform3D to_global = get_global_transform();
+  return TilePick{.mesh = tile->mesh().ptr(),
+                  .instance = tile->mesh_instance(),
+                  .position = origin + direction * *t,
+                  .normal = (to_global.xform(Vector3(0, 1, 0)) - to_global.xform(Vector3(0, 0, 0))).normalized()};
+}
+
+Tile* HexGrid::tile_at(OffsetCoordinates coords) const { return _tile_index.at(offsetToCube(coords)); }
+
+void HexGrid::index_tiles() {
+  std::vector<std::pair<CubeCoordinates, Tile*>> tiles;
+  for (std::vector<Tile*>& row : _tiles_layout) {
+    for (Tile* tile : row) {
+      tiles.emplace_back(tile->get_cube_coords(), tile);
+    }
+  }
+  _tile_index.assign(tiles);
 }
 
 Array HexGrid::get_hex_meshes() {
   Array result;
+  if (is_generating()) {
+    return result;
+  }
   for (std::vector<Tile*>& row : _tiles_layout) {
     for (Tile* tile : row) {
       result.append(tile->mesh()->inner_mesh());
@@ -147,13 +576,19 @@ void RectHexGrid::_bind_methods() {
 }
 
 void RectHexGrid::set_height(const int p_height) {
+  if (queue_if_generating("set_height", p_height)) {
+    return;
+  }
   _height = p_height > 1 ? p_height : 1;
-  init();
+  request_init();
 }
 
 void RectHexGrid::set_width(const int p_width) {
+  if (queue_if_generating("set_width", p_width)) {
+    return;
+  }
   _width = p_width > 1 ? p_width : 1;
-  init();
+  request_init();
 }
 
 int RectHexGrid::get_height() const { return _height; }
@@ -173,8 +608,11 @@ void HexagonalHexGrid::_bind_methods() {
 }
 
 void HexagonalHexGrid::set_size(const int p_size) {
+  if (queue_if_generating("set_size", p_size)) {
+    return;
+  }
   _size = p_size > 1 ? p_size : 1;
-  init();
+  request_init();
 }
 
 int HexagonalHexGrid::get_size() const { return _size; }
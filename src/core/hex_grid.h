@@ -1,21 +1,29 @@
 #pragma once
 
-#include <map>  // for map
-#include <memory>
-#include <vector>  // for vector
+#include <functional>  // for function
+#include <memory>      // for unique_ptr
+#include <optional>    // for optional
+#include <vector>      // for vector
 
+#include "core/async_generation.h"  // for AsyncGeneration
 #include "core/hex_mesh.h"
+#include "core/material_cache.h"    // for MaterialCache
+#include "core/tile_picker.h"       // for TilePicker, TilePick
 #include "misc/cube_coordinates.h"  // for CubeCoordinates
 #include "misc/tile.h"
+#include "misc/tile_index.h"  // for TileIndex
 #include "misc/types.h"
-#include "tal/arrays.h"     // for Array
-#include "tal/node.h"       // for Node3D
-#include "tal/reference.h"  // for Ref
-#include "tal/shader.h"     // for Shader
-#include "tal/vector3i.h"   // for Vector3i
+#include "tal/arrays.h"      // for Array
+#include "tal/event.h"       // for InputEvent
+#include "tal/godot_core.h"  // for Variant
+#include "tal/node.h"        // for Node3D
+#include "tal/reference.h"   // for Ref
+#include "tal/shader.h"      // for Shader
+#include "tal/vector3i.h"    // for Vector3i
 #include "tal/wrapped.h"
 
 namespace sota {
+class Chunk;
 class Tile;
 class TileMesh;
 
@@ -42,30 +50,192 @@ class HexGrid : public Node3D {
   void set_frame_offset(const float p_offset);
   float get_frame_offset() const;
 
+  /**
+   * @brief Property shared with Godot inspector. Tiles share vertices of their lattices and are smooth shaded, see
+   * SotaMesh::set_indexed()
+   */
+  void set_indexed(const bool p_indexed);
+  bool get_indexed() const;
+
+  void set_mesh_attributes(const int p_mesh_attributes);
+  int get_mesh_attributes() const;
+
+  void set_direct_upload(const bool p_direct_upload);
+  bool get_direct_upload() const;
+
+  void set_lod_levels(const int p_lod_levels);
+  int get_lod_levels() const;
+
+  void set_lod_distance(const float p_lod_distance);
+  float get_lod_distance() const;
+
+  /**
+   * @brief Property shared with Godot inspector. Tiles of chunk_size x chunk_size block of grid are drawn as single
+   * surface, see Chunk. 0 means every tile has its own mesh instance. Levels of detail are used only in that case
+   */
+  void set_chunk_size(const int p_chunk_size);
+  int get_chunk_size() const;
+
+  /**
+   * @brief Property shared with Godot inspector. If set, tile under mouse is found by intersection of ray of camera
+   * with plane of grid instead of physics bodies, so tiles don't create them
+   */
+  void set_analytic_picking(const bool p_analytic_picking);
+  bool get_analytic_picking() const;
+
+  /**
+   * @brief Tile mesh hit by ray given in global space, null if there is no tile. Heights of tiles are ignored, ray is
+   * intersected with plane of grid
+   */
+  Ref<TileMesh> pick_tile(Vector3 origin, Vector3 direction) const;
+
   virtual int calculate_id(int row, int col) const = 0;
 
   virtual void calculate_normals() {}
 
   Array get_hex_meshes();
 
+  /**
+   * @brief Schedules init() at the end of frame. Requests made before that result in single init()
+   */
+  void request_init();
+
+  /**
+   * @brief Builds tiles on background thread, "progress" signal reports share of work done. New tiles replace old
+   * ones in one frame and "finished" is emitted then, old tiles are visible until that. Properties set while
+   * generation is running are applied after it's finished, init() requested meanwhile is postponed as well
+   */
+  virtual void generate_async();
+  virtual void finish_generation();
+  bool is_generating() const { return _generation.is_running(); }
+
+#ifdef SOTA_GDEXTENSION
+  void _unhandled_input(const Ref<InputEvent>& p_event) override;
+#else
+  void unhandled_input(const Ref<InputEvent>& p_event) override;
+#endif
+
  protected:
   float _diameter{1};
   int _divisions{3};
   Ref<Shader> _shader;
   std::vector<std::vector<Vector3i>> _col_row_layout;
+  // view of _tiles by offset coordinates
   TilesLayout _tiles_layout;
+  std::vector<std::unique_ptr<Tile>> _tiles;
+  // materials are shared by tiles, created by init_materials()
+  MaterialCache _materials;
 
   static void _bind_methods();
+  void _notification(int p_what);
   virtual void init();
+  /**
+   * @brief Creates materials used by tiles. Called on the main thread before generate()
+   */
+  virtual void init_materials();
+  /**
+   * @brief Builds tiles and their meshes from scratch. Runs on background thread during generate_async(), so it
+   * doesn't create nodes or upload meshes and reports progress by report_progress()
+   */
+  virtual void generate();
+  /**
+   * @brief Shows tiles built by generate(): creates their nodes, levels of detail and chunks and uploads meshes.
+   * Called on the main thread
+   */
+  virtual void publish();
+  void report_progress(float ratio) const { _generation.report_progress(ratio); }
+  /**
+   * @brief Whether owner is being deleted while generation runs. Generation returns early between stages then
+   */
+  bool is_cancelled() const { return _generation.is_cancelled(); }
+  /**
+   * @brief Queues call of setter with value while generation is running, since background thread reads properties
+   *
+   * @return whether setter should return without changing property
+   */
+  bool queue_if_generating(const char* setter, const Variant& value) { return _generation.queue_call(setter, value); }
+
+  /**
+   * @brief Takes ownership of tile, caller places it into layout
+   */
+  Tile* add_tile(std::unique_ptr<Tile> tile);
+  /**
+   * @brief Drops all tiles. Nodes of tiles stay visible until publish() deletes them
+   */
+  void retire_tiles();
 
   virtual void init_col_row_layout() = 0;
   virtual void init_hexmesh();
-  std::map<CubeCoordinates, TileMesh*> _cube_to_hexagon;
+  /**
+   * @brief Whether init_hexmesh() may reuse nodes and meshes of current tiles instead of creating them again. It's the
+   * case if layout of tiles and the way they are drawn are unchanged, and tiles are built on the main thread. Meshes of
+   * current tiles are shown until background generation is finished, so it never changes them
+   */
+  bool can_reuse_tiles() const;
+  /**
+   * @brief Set by owner on the main thread before tiles are built, see can_reuse_tiles()
+   */
+  void allow_reuse(bool allowed) { _reuse_allowed = allowed; }
+  /**
+   * @brief Builds lower levels of detail of tiles for every LOD_BLOCK_SIZE x LOD_BLOCK_SIZE block of grid. Called
+   * after heights of tiles are final, chunks of levels are created by init_lods()
+   */
+  void calculate_lods();
+  /**
+   * @brief Merges levels of detail of every block into one chunk per level. Level i (starting from 1) is visible from
+   * lod_distance * i, chunks of block and its tiles hide each other as hierarchical levels of detail
+   */
+  void init_lods();
+  /**
+   * @brief Merges tiles into chunks if chunk_size is set. Called by publish()
+   */
+  virtual void init_chunks();
+  void add_chunks(const std::function<SotaMesh*(Tile*)>& tile_mesh);
+  /**
+   * @brief Deletes chunks immediately, so meshes of tiles can be chunked again
+   */
+  void clear_chunks();
+  bool is_batched() const { return _chunk_size > 0; }
+  std::optional<TilePick> pick(Vector3 origin, Vector3 direction) const;
+  Tile* tile_at(OffsetCoordinates coords) const;
+  /**
+   * @brief Fills index of tiles by cube coordinates. Called after tiles are created
+   */
+  void index_tiles();
+  TileIndex<Tile> _tile_index;
+  std::vector<Chunk*> _chunks;
+  // chunks of every level of detail
+  std::vector<std::vector<Chunk*>> _lod_chunks;
 
   bool _frame_state{false};
   float _frame_offset{0.0};
+  bool _indexed{false};
+  int _mesh_attributes{DEFAULT_MESH_ATTRIBUTES};
+  bool _direct_upload{false};
+  int _lod_levels{1};
+  float _lod_distance{25.0};
+  int _chunk_size{0};
+  bool _analytic_picking{false};
+  TilePicker _picker;
 
  private:
+  // levels of detail of block of grid and tiles hidden by them
+  struct LodBlock {
+    std::vector<std::vector<Ref<SotaMesh>>> levels;
+    std::vector<Tile*> tiles;
+  };
+
+  bool _init_requested{false};
+  bool _init_postponed{false};
+  bool _reuse_allowed{false};
+  AsyncGeneration _generation;
+  // tiles replaced by generation, deleted by publish()
+  std::vector<std::unique_ptr<Tile>> _retired_tiles;
+  std::vector<LodBlock> _lod_blocks;
+
+  void deferred_init();
+  void update_lod_ranges();
+  void clear_lods();
 };
 
 class RectHexGrid : public HexGrid {
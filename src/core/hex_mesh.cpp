@@ -1,29 +1,37 @@
 #include "hex_mesh.h"
 
+#include <array>   // for array
 #include <cmath>   // for sqrt
 #include <memory>  // for make_unique
 #include <vector>  // for vector
 
-#include "core/mesh.h"           // for SotaMesh, Tess...
-#include "core/utils.h"          // for radius, small_...
-#include "misc/types.h"          // for ClipOptions
-#include "primitives/edge.h"     // for Edge
-#include "primitives/hexagon.h"  // for Hexagon, make_...
-#include "primitives/polygon.h"  // for RegularPolygon
-#include "tal/arrays.h"          // for Vector3Array
-#include "tal/godot_core.h"      // for D_METHOD, ClassDB
-#include "tal/reference.h"       // for Ref
-#include "tal/vector2.h"         // for Vector2
-#include "tal/vector3.h"         // for Vector3
+#include "core/lattice_mesher.h"  // for LatticeMesher, LatticePoint
+#include "core/mesh.h"            // for SotaMesh, Tess...
+#include "core/utils.h"           // for radius, small_...
+#include "misc/types.h"           // for ClipOptions
+#include "primitives/edge.h"      // for Edge
+#include "primitives/hexagon.h"   // for Hexagon, make_...
+#include "primitives/polygon.h"   // for RegularPolygon
+#include "tal/arrays.h"           // for Vector3Array
+#include "tal/godot_core.h"       // for D_METHOD, ClassDB
+#include "tal/reference.h"        // for Ref
+#include "tal/vector2.h"          // for Vector2
+#include "tal/vector3.h"          // for Vector3
 
 namespace sota {
 
 SimpleMesh::SimpleMesh(Hexagon hex, HexMeshParams params) : _hex_mesh(Ref<HexMesh>(memnew(HexMesh(hex, params)))) {
-  _hex_mesh->init();
+  // uploaded by owner on the main thread
+  _hex_mesh->build();
 }
 
 int SimpleMesh::get_id() { return _hex_mesh->get_id(); }
 
+void SimpleMesh::reset(Hexagon hex, HexMeshParams params) {
+  _hex_mesh->reset(hex, params);
+  _hex_mesh->build();
+}
+
 HexMesh::HexMesh() : SotaMesh(std::make_unique<Hexagon>(make_unit_hexagon())) {
   _R = radius(_diameter);
   _r = small_radius(_diameter);
@@ -31,28 +39,20 @@ HexMesh::HexMesh() : SotaMesh(std::make_unique<Hexagon>(make_unit_hexagon())) {
   init();  // for init in godot
 }
 
-HexMesh::HexMesh(Hexagon hex, HexMeshParams params) : SotaMesh(std::make_unique<Hexagon>(hex)) {
-  _R = radius(_diameter);
-  _r = small_radius(_diameter);
+HexMesh::HexMesh(Hexagon hex, HexMeshParams params) : SotaMesh(std::make_unique<Hexagon>(hex)) { set_params(params); }
 
-  _id = params.id;
-  _diameter = params.diameter;
-  _frame_state = params.frame_state;
-  _frame_offset = params.frame_offset;
-  set_material(params.material);
-  _divisions = params.divisions;
-  _clip_options = params.clip_options;
-  _tesselation_mode = params.tesselation_mode;
-  _orientation = params.orientation;
-}
+HexMesh::HexMesh(Hexagon hex) : SotaMesh(std::make_unique<Hexagon>(hex)) { set_params(HexMeshParams{}); }
 
-HexMesh::HexMesh(Hexagon hex) : SotaMesh(std::make_unique<Hexagon>(hex)) {
-  auto params = HexMeshParams{};
-  _R = radius(_diameter);
-  _r = small_radius(_diameter);
+void HexMesh::reset(Hexagon hex, HexMeshParams params) {
+  set_base(std::make_unique<Hexagon>(hex));
+  set_params(params);
+}
 
+void HexMesh::set_params(const HexMeshParams& params) {
   _id = params.id;
   _diameter = params.diameter;
+  _R = radius(_diameter);
+  _r = small_radius(_diameter);
   _frame_state = params.frame_state;
   _frame_offset = params.frame_offset;
   set_material(params.material);
@@ -60,9 +60,14 @@ HexMesh::HexMesh(Hexagon hex) : SotaMesh(std::make_unique<Hexagon>(hex)) {
   _clip_options = params.clip_options;
   _tesselation_mode = params.tesselation_mode;
   _orientation = params.orientation;
+  _indexed = params.indexed;
+  _attributes = params.attributes;
+  _direct_upload = params.direct_upload;
 }
 
-void HexMesh::init_impl() {
+void HexMesh::init_impl() { init_from_template(); }
+
+void HexMesh::calculate_vertices() {
   if (_tesselation_mode == TesselationMode::Iterative) {
     calculate_vertices_iteration();
     if (_frame_state) {
@@ -71,7 +76,35 @@ void HexMesh::init_impl() {
   } else if (_tesselation_mode == TesselationMode::Recursive) {
     calculate_vertices_recursion();
   }
-  recalculate_all_except_vertices();
+}
+
+TesselationKey HexMesh::tesselation_key() const {
+  TesselationKey key = SotaMesh::tesselation_key();
+  key.clip_mask = _clip_options.left | _clip_options.right << 1 | _clip_options.up << 2 | _clip_options.down << 3;
+  key.frame_state = _frame_state;
+  key.frame_offset = _frame_state ? _frame_offset : 0;
+  return key;
+}
+
+Ref<SotaMesh> HexMesh::make_lod(int divisions) const {
+  if (_orientation != Orientation::Plane || _decimated) {
+    return Ref<SotaMesh>();
+  }
+  // frame is not a part of height field, so levels of detail are built without it
+  HexMeshParams params{.id = _id,
+                       .diameter = _diameter,
+                       .material = get_material(),
+                       .divisions = divisions,
+                       .clip_options = _clip_options,
+                       .tesselation_mode = _tesselation_mode,
+                       .orientation = _orientation,
+                       .indexed = _indexed,
+                       .attributes = _attributes,
+                       .direct_upload = _direct_upload};
+  Ref<HexMesh> lod = Ref<HexMesh>(memnew(HexMesh(static_cast<const Hexagon&>(*_base_ngon), params)));
+  lod->init_impl();
+  lod->fit_to_lod_source(*this);
+  return lod;
 }
 
 void HexMesh::_bind_methods() {
@@ -101,75 +134,12 @@ void HexMesh::set_diameter(const float p_diameter) {
 
 float HexMesh::get_diameter() const { return _diameter; }
 
-void HexMesh::z_clip(float boundary) {
-  float z_step = _R / _divisions;
-  float half_z_step = z_step / 2;
-
-  Vector3Array filtered;
-  int n = vertices_.size();
-  for (int i = 0; i < n; i += 3) {
-    Vector3 p0 = vertices_[i];
-    Vector3 p1 = vertices_[i + 1];
-    Vector3 p2 = vertices_[i + 2];
-    int vertices_to_fix = 0;
-    Vector3* to_fix;
-    if (boundary > 0) {
-      if (p0.z > (boundary + EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p0;
-      }
-      if (p1.z > (boundary + EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p1;
-      }
-      if (p2.z > (boundary + EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p2;
-      }
-    } else {
-      if (p0.z < (boundary - EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p0;
-      }
-      if (p1.z < (boundary - EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p1;
-      }
-      if (p2.z < (boundary - EPSILON)) {
-        ++vertices_to_fix;
-        to_fix = &p2;
-      }
-    }
-
-    if (vertices_to_fix > 1) {
-      // don't add vertices of triangle to filtered
-      continue;
-    } else if (vertices_to_fix == 1) {
-      // just 1 vertex, fix it
-      if (boundary > 0) {
-        to_fix->z -= half_z_step;
-      } else {
-        to_fix->z += half_z_step;
-      }
-    }
-    filtered.append_array({p0, p1, p2});
-  }
-  vertices_ = filtered;
-}
-
 void HexMesh::calculate_vertices_recursion() {
-  vertices_.clear();
   auto corner_points = _base_ngon->points();
-  Vector3 c = (corner_points[0] + corner_points[3]) / 2;
-  for (int i = 0; i < 6; ++i) {
-    tesselate_into_triangles(corner_points[i], corner_points[(i + 1) % 6], c, _divisions);
-  }
-  return;
+  tesselate_fan(corner_points, (corner_points[0] + corner_points[3]) / 2, _divisions);
 }
 
 void HexMesh::calculate_vertices_iteration() {
-  vertices_.clear();
-
   auto corner_points = _base_ngon->points();
   auto center = _base_ngon->center();
   auto normal = _base_ngon->normal();
@@ -189,51 +159,84 @@ void HexMesh::calculate_vertices_iteration() {
   Vector3 start_point_even = pivot;
   Vector3 start_point_odd = pivot + half_d0_inc + d1_inc;
 
+  // point of lattice is pivot + a * half_d0_inc + b * d1_inc, other half of hexagon has negative b
+  struct Point {
+    Vector3 position;
+    int a;
+    int b;
+  };
+  int a_count = 4 * _divisions + 1;
+  auto key = [this, a_count](int a, int b) { return (b + _divisions) * a_count + a; };
+
+  // Clipped tiles are cut at half of circumradius from center. Triangles with 2 or 3 vertices beyond the cut are
+  // skipped, single vertex beyond it is moved onto the cut. Moved vertex doesn't coincide with other lattice point, so
+  // it keeps key of its lattice point
+  bool z_clipped = _clip_options.down || _clip_options.up;
+  float boundary = _clip_options.down ? -_R / 2 : _R / 2;
+  float half_z_step = _R / _divisions / 2;
+  auto beyond = [center, boundary](Vector3 p) {
+    return boundary > 0 ? p.z - center.z > boundary + EPSILON : p.z - center.z < boundary - EPSILON;
+  };
+
+  // triangles of half of hexagon lying on one side of line from pivot to center
+  std::vector<std::array<Point, 3>> half;
+  half.reserve(3 * _divisions * _divisions);
+  auto emit = [&](Point p0, Point p1, Point p2) {
+    if (z_clipped) {
+      Point* p[3] = {&p0, &p1, &p2};
+      int vertices_to_fix = 0;
+      Point* to_fix = nullptr;
+      for (Point* point : p) {
+        if (beyond(point->position)) {
+          ++vertices_to_fix;
+          to_fix = point;
+        }
+      }
+      if (vertices_to_fix > 1) {
+        return;
+      }
+      if (vertices_to_fix == 1) {
+        to_fix->position.z += boundary > 0 ? -half_z_step : half_z_step;
+      }
+    }
+    half.push_back({p0, p1, p2});
+  };
+
   for (int layer = 0; layer < _divisions; ++layer, triangles_count -= 2) {
-    Vector3 point_even = start_point_even + (layer * half_d0_inc) + (layer * d1_inc);
-    Vector3 point_odd = start_point_odd + (layer * half_d0_inc) + (layer * d1_inc);
+    Point even{start_point_even + (layer * half_d0_inc) + (layer * d1_inc), layer, layer};
+    Point odd{start_point_odd + (layer * half_d0_inc) + (layer * d1_inc), layer + 1, layer + 1};
     for (unsigned int i = 0; i < triangles_count; ++i) {
       if (is_odd(i)) {
-        vertices_.push_back(point_odd);
-        vertices_.push_back(point_odd + half_d0_inc - d1_inc);
-        vertices_.push_back(point_odd + d0_inc);
-
-        point_odd += d0_inc;
-
+        emit(odd, Point{odd.position + half_d0_inc - d1_inc, odd.a + 1, odd.b - 1},
+             Point{odd.position + d0_inc, odd.a + 2, odd.b});
+        odd.position += d0_inc;
+        odd.a += 2;
       } else {
-        vertices_.push_back(point_even);
-        vertices_.push_back(point_even + d0_inc);
-        vertices_.push_back(point_even + half_d0_inc + d1_inc);
-
-        point_even += d0_inc;
+        emit(even, Point{even.position + d0_inc, even.a + 2, even.b},
+             Point{even.position + half_d0_inc + d1_inc, even.a + 1, even.b + 1});
+        even.position += d0_inc;
+        even.a += 2;
       }
     }
   }
 
-  if (_clip_options.down) {
-    z_clip(-_R / 2);
-  } else if (_clip_options.up) {
-    z_clip(_R / 2);
-  }
-
-  if (_clip_options.left) {
-    return;
-  }
-
-  Vector3Array copy = vertices_;
-  int n = vertices_.size();
-
-  auto reflected = [center, direction0](Vector3 v) -> Vector3 { return (v - center).reflect(direction0) + center; };
-
-  if (_clip_options.right) {
-    vertices_.clear();
+  // other half is reflection of the first one, right clip replaces first half by it
+  LatticeMesher mesher(_indexed, (2 * _divisions + 1) * a_count);
+  auto lattice_point = [key](const Point& p) { return LatticePoint{p.position, key(p.a, p.b)}; };
+  auto reflected = [key, center, direction0](const Point& p) {
+    return LatticePoint{(p.position - center).reflect(direction0) + center, key(p.a, -p.b)};
+  };
+  if (_clip_options.left || !_clip_options.right) {
+    for (const auto& [p0, p1, p2] : half) {
+      mesher.add_triangle(lattice_point(p0), lattice_point(p1), lattice_point(p2));
+    }
   }
-  for (int i = 0; i < n; i += 3) {
-    Vector3 p0 = reflected(copy[i]);
-    Vector3 p1 = reflected(copy[i + 1]);
-    Vector3 p2 = reflected(copy[i + 2]);
-    vertices_.append_array({p0, p2, p1});
+  if (!_clip_options.left) {
+    for (const auto& [p0, p1, p2] : half) {
+      mesher.add_triangle(reflected(p0), reflected(p2), reflected(p1));
+    }
   }
+  mesher.finish(vertices_, indices_);
 }
 
 void HexMesh::calculate_tex_uv1() {
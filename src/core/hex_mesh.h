@@ -34,6 +34,9 @@ struct HexMeshParams {
   TesselationMode tesselation_mode{TesselationMode::Iterative};
   // TODO remove default arg field and make ctor instead
   Orientation orientation{Orientation::Plane};
+  bool indexed{false};
+  int attributes{DEFAULT_MESH_ATTRIBUTES};
+  bool direct_upload{false};
 };
 
 class HexMesh : public SotaMesh {
@@ -56,11 +59,21 @@ class HexMesh : public SotaMesh {
 
   HexMesh(Hexagon hex, HexMeshParams params);
 
+  /**
+   * @brief Moves mesh to other hexagon and replaces its parameters, as if it was constructed again. Arrays are rebuilt
+   * in place by next build() or init(), so storage of mesh is reused
+   */
+  void reset(Hexagon hex, HexMeshParams params);
+
+  Ref<SotaMesh> make_lod(int divisions) const override;
+
  protected:
   HexMesh(Hexagon hex);
 
   static void _bind_methods();
   void init_impl() override;
+  void calculate_vertices() override;
+  TesselationKey tesselation_key() const override;
 
   void calculate_vertices_recursion();  // not tested e.g. for clips
   void calculate_vertices_iteration();
@@ -75,10 +88,9 @@ class HexMesh : public SotaMesh {
   ClipOptions _clip_options;
 
  private:
+  void set_params(const HexMeshParams& params);
   void add_frame();
   void calculate_tex_uv1() override;
-
-  void z_clip(float boundary);
 };
 
 class SimpleMesh : public TileMesh {
@@ -89,6 +101,11 @@ class SimpleMesh : public TileMesh {
   HexMesh* inner_mesh() const override { return _hex_mesh.ptr(); }
   SimpleMesh(Hexagon hex, HexMeshParams params);
 
+  /**
+   * @brief See HexMesh::reset(). Mesh is tesselated again, owner uploads it
+   */
+  void reset(Hexagon hex, HexMeshParams params);
+
  protected:
   static void _bind_methods() {}
 
@@ -0,0 +1,51 @@
+#include "core/lattice_mesher.h"
+
+#include "tal/arrays.h"   // for Vector3Array, IntArray
+#include "tal/vector3.h"  // for Vector3
+
+namespace sota {
+
+LatticeMesher::LatticeMesher(bool indexed, int keys_count) : _indexed(indexed) {
+  if (_indexed) {
+    _vertex_of_key.assign(keys_count, -1);
+  }
+}
+
+void LatticeMesher::add_triangle(const LatticePoint& a, const LatticePoint& b, const LatticePoint& c) {
+  add_point(a);
+  add_point(b);
+  add_point(c);
+}
+
+void LatticeMesher::add_point(const LatticePoint& p) {
+  if (!_indexed) {
+    _vertices.push_back(p.position);
+    return;
+  }
+  int& vertex = _vertex_of_key[p.key];
+  if (vertex == -1) {
+    vertex = _vertices.size();
+    _vertices.push_back(p.position);
+  }
+  _indices.push_back(vertex);
+}
+
+void LatticeMesher::finish(Vector3Array& vertices, IntArray& indices) const {
+  int n = _vertices.size();
+  vertices.resize(n);
+  Vector3* v = vertices.ptrw();
+  for (int i = 0; i < n; ++i) {
+    v[i] = _vertices[i];
+  }
+  if (!_indexed) {
+    return;
+  }
+  int m = _indices.size();
+  indices.resize(m);
+  int* index = indices.ptrw();
+  for (int i = 0; i < m; ++i) {
+    index[i] = _indices[i];
+  }
+}
+
+}  // namespace sota
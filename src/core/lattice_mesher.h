@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>  // for vector
+
+#include "tal/arrays.h"   // for Vector3Array, IntArray
+#include "tal/vector3.h"  // for Vector3
+
+namespace sota {
+
+/**
+ * @brief Point of tesselation lattice. Points with the same key are the same vertex of indexed mesh
+ */
+struct LatticePoint {
+  Vector3 position;
+  int key{0};
+};
+
+/**
+ * @brief Collects triangles of tesselation. In indexed mode vertex of lattice point is added on first use of its key,
+ * so triangles share vertices without welding. Otherwise every triangle gets its own vertices
+ */
+class LatticeMesher {
+ public:
+  /**
+   * @param keys_count - keys of lattice points are in range [0, keys_count)
+   */
+  LatticeMesher(bool indexed, int keys_count);
+
+  void add_triangle(const LatticePoint& a, const LatticePoint& b, const LatticePoint& c);
+
+  /**
+   * @brief Writes collected vertices. Index buffer is written in indexed mode only
+   */
+  void finish(Vector3Array& vertices, IntArray& indices) const;
+
+ private:
+  bool _indexed;
+  // index of vertex of every key, -1 until key is used
+  std::vector<int> _vertex_of_key;
+  std::vector<Vector3> _vertices;
+  std::vector<int> _indices;
+
+  void add_point(const LatticePoint& p);
+};
+
+}  // namespace sota
@@ -0,0 +1,41 @@
+#include "core/material_cache.h"
+
+#include <functional>  // for function
+
+#include "tal/material.h"   // for ShaderMaterial
+#include "tal/reference.h"  // for Ref
+#include "tal/shader.h"     // for Shader
+
+namespace sota {
+
+Ref<ShaderMaterial> MaterialCache::get(const Ref<Shader>& shader, int variant,
+                                       const std::function<void(Ref<ShaderMaterial>)>& configure) {
+  MaterialKey key{.shader = shader.ptr(), .variant = variant};
+  if (auto it = _materials.find(key); it != _materials.end()) {
+    return it->second;
+  }
+
+  Ref<ShaderMaterial> material;
+  material.instantiate();
+  if (shader.ptr()) {
+    material->set_shader(shader);
+  }
+  configure(material);
+  _materials[key] = material;
+  return material;
+}
+
+Ref<ShaderMaterial> MaterialCache::find(const Ref<Shader>& shader, int variant) const {
+  auto it = _materials.find(MaterialKey{.shader = shader.ptr(), .variant = variant});
+  return it != _materials.end() ? it->second : Ref<ShaderMaterial>();
+}
+
+void MaterialCache::reconfigure(const std::function<void(int, Ref<ShaderMaterial>)>& configure) {
+  for (auto& [key, material] : _materials) {
+    configure(key.variant, material);
+  }
+}
+
+void MaterialCache::clear() { _materials.clear(); }
+
+}  // namespace sota
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <compare>     // for operator<=>
+#include <functional>  // for function
+#include <map>         // for map
+
+#include "tal/material.h"   // for ShaderMaterial
+#include "tal/reference.h"  // for Ref
+#include "tal/shader.h"     // for Shader
+
+namespace sota {
+
+/**
+ * @brief Identifies set of shader parameters. Parameters shared by all tiles come from state of owner of cache, so
+ * only shader and variant (e.g. biome) differ between materials
+ */
+struct MaterialKey {
+  const Shader* shader{nullptr};
+  int variant{0};
+
+  auto operator<=>(const MaterialKey&) const = default;
+};
+
+/**
+ * @brief Storage of materials shared by tiles with identical parameters. Owned by grid or polyhedron and filled on the
+ * main thread before tiles are rebuilt. Per-tile variation (e.g. selection) is done by instance uniforms
+ */
+class MaterialCache {
+ public:
+  /**
+   * @brief Returns material for key. Calls configure only for newly created material, shader is already set
+   */
+  Ref<ShaderMaterial> get(const Ref<Shader>& shader, int variant,
+                          const std::function<void(Ref<ShaderMaterial>)>& configure);
+
+  /**
+   * @brief Returns stored material for key, null if there is none. Doesn't create materials, so tiles built on
+   * background thread use it
+   */
+  Ref<ShaderMaterial> find(const Ref<Shader>& shader, int variant) const;
+
+  /**
+   * @brief Configures every stored material again, e.g. after change of parameters which don't require new tiles
+   */
+  void reconfigure(const std::function<void(int, Ref<ShaderMaterial>)>& configure);
+
+  void clear();
+
+ private:
+  std::map<MaterialKey, Ref<ShaderMaterial>> _materials;
+};
+
+}  // namespace sota
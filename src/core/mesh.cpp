@@ -1,15 +1,78 @@
 #include "core/mesh.h"
 
-#include "core/dummy_mesher.h"  // for DummyMesher
-#include "tal/arrays.h"         // for Vector3Array, Array, ByteArray
-#include "tal/godot_core.h"     // for D_METHOD, ClassDB, Property...
-#include "tal/vector3.h"        // for Vector3
+#include <algorithm>  // for clamp, fill, max, min, min_element, reverse, sort
+#include <cmath>      // for lround
+#include <map>        // for map
+#include <utility>    // for pair
+#include <vector>     // for vector
+
+#include "core/chunk.h"              // for Chunk
+#include "core/dummy_mesher.h"       // for DummyMesher
+#include "core/lattice_mesher.h"     // for LatticeMesher, LatticePoint
+#include "core/planar_decimator.h"   // for PlanarDecimator
+#include "core/surface_regions.h"    // for SurfaceRegions
+#include "core/tesselation_cache.h"  // for TesselationCache, Tesselation
+#include "core/utils.h"              // for EPSILON
+#include "misc/discretizer.h"        // for DiscreteVertex, VertexToNormalDiscretizer
+#include "tal/arrays.h"              // for Vector3Array, Array, ByteArray
+#include "tal/godot_core.h"          // for D_METHOD, ClassDB, Property...
+#include "tal/material.h"            // for Material
+#include "tal/reference.h"           // for Ref
+#include "tal/vector2.h"             // for Vector2
+#include "tal/vector3.h"             // for Vector3
 
 namespace sota {
 
+namespace {
+
+// point of triangle (corner, next corner, center) of fan, s and t are coordinates along sides from center to corners
+// in units of 1 / n of side
+struct FanPoint {
+  Vector3 position;
+  int s;
+  int t;
+};
+
+template <typename Key>
+void tesselate_into_triangles(LatticeMesher& mesher, const Key& key, FanPoint a, FanPoint b, FanPoint c, int level) {
+  --level;
+  if (!level) {
+    mesher.add_triangle({a.position, key(a)}, {b.position, key(b)}, {c.position, key(c)});
+    return;
+  }
+  auto middle = [](FanPoint p, FanPoint q) {
+    return FanPoint{(p.position + q.position) / 2, (p.s + q.s) / 2, (p.t + q.t) / 2};
+  };
+  FanPoint ab = middle(a, b);
+  FanPoint bc = middle(b, c);
+  FanPoint ca = middle(c, a);
+  tesselate_into_triangles(mesher, key, a, ab, ca, level);
+  tesselate_into_triangles(mesher, key, ca, bc, c, level);
+  tesselate_into_triangles(mesher, key, bc, ab, b, level);
+  tesselate_into_triangles(mesher, key, ca, ab, bc, level);
+}
+
+}  // namespace
+
 void SotaMesh::init() {
+  build();
+  upload();
+}
+
+void SotaMesh::build() {
+  _decimated = false;
+  _decimation_stats = DecimationStats();
   init_impl();
-  request_update();
+  _surface_layout_changed = true;
+}
+
+void SotaMesh::recalculate_dirty() {
+  if (_normals_dirty) {
+    calculate_normals();
+  }
+  if (_tex_uv1_dirty) {
+    calculate_tex_uv1_if_needed();
+  }
 }
 
 void SotaMesh::_bind_methods() {
@@ -17,6 +80,19 @@ void SotaMesh::_bind_methods() {
   ClassDB::bind_method(D_METHOD("set_divisions", "p_divisions"), &SotaMesh::set_divisions);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "divisions"), "set_divisions", "get_divisions");
 
+  ClassDB::bind_method(D_METHOD("is_indexed"), &SotaMesh::is_indexed);
+  ClassDB::bind_method(D_METHOD("set_indexed", "p_indexed"), &SotaMesh::set_indexed);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "indexed"), "set_indexed", "is_indexed");
+
+  ClassDB::bind_method(D_METHOD("get_attributes"), &SotaMesh::get_attributes);
+  ClassDB::bind_method(D_METHOD("set_attributes", "p_attributes"), &SotaMesh::set_attributes);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "attributes", PROPERTY_HINT_FLAGS, MESH_ATTRIBUTES_HINT), "set_attributes",
+               "get_attributes");
+
+  ClassDB::bind_method(D_METHOD("is_direct_upload"), &SotaMesh::is_direct_upload);
+  ClassDB::bind_method(D_METHOD("set_direct_upload", "p_direct_upload"), &SotaMesh::set_direct_upload);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "direct_upload"), "set_direct_upload", "is_direct_upload");
+
   ClassDB::bind_method(D_METHOD("get_vertices"), &SotaMesh::get_vertices);
   ClassDB::bind_method(D_METHOD("set_vertices", "vertices"), &SotaMesh::set_vertices);
 }
@@ -28,93 +104,464 @@ void SotaMesh::set_divisions(const int p_divisions) {
 
 int SotaMesh::get_divisions() const { return _divisions; }
 
-void SotaMesh::tesselate_into_triangles(Vector3 a, Vector3 b, Vector3 c, int level) {
-  --level;
-  if (!level) {
-    vertices_.append_array(Vector3Array{a, b, c});
+void SotaMesh::set_indexed(const bool p_indexed) {
+  _indexed = p_indexed;
+  init();
+}
+
+bool SotaMesh::is_indexed() const { return _indexed; }
+
+void SotaMesh::set_attributes(const int p_attributes) {
+  _attributes = p_attributes;
+  recalculate_all_except_vertices();
+  upload();
+}
+
+int SotaMesh::get_attributes() const { return _attributes; }
+
+void SotaMesh::set_direct_upload(const bool p_direct_upload) {
+  _direct_upload = p_direct_upload;
+  _surface_layout_changed = true;
+  if (!_direct_upload) {
+    // bounds are calculated by PrimitiveMesh again
+    RenderingServer::get_singleton()->mesh_set_custom_aabb(get_rid(), AABB());
+  }
+  upload();
+}
+
+bool SotaMesh::is_direct_upload() const { return _direct_upload; }
+
+TesselationKey SotaMesh::tesselation_key() const {
+  return TesselationKey{.sides = static_cast<int>(_base_ngon->points().size()),
+                        .divisions = _divisions,
+                        .tesselation_mode = static_cast<int>(_tesselation_mode),
+                        .indexed = _indexed,
+                        .attributes = _attributes,
+                        .radius_steps = static_cast<int>(std::lround(get_R() / EPSILON))};
+}
+
+void SotaMesh::init_from_template() {
+  if (_orientation != Orientation::Plane) {
+    // tiles of polyhedron differ by rotation, not only by translation
+    _tesselation = nullptr;
+    calculate_vertices();
+    recalculate_all_except_vertices();
     return;
   }
-  Vector3 ab = (a + b) / 2;
-  Vector3 bc = (b + c) / 2;
-  Vector3 ca = (c + a) / 2;
-  tesselate_into_triangles(a, ab, ca, level);
-  tesselate_into_triangles(ca, bc, c, level);
-  tesselate_into_triangles(bc, ab, b, level);
-  tesselate_into_triangles(ca, ab, bc, level);
+
+  Vector3 center = _base_ngon->center();
+  _tesselation = TesselationCache::instance().get(tesselation_key(), [this, center]() {
+    calculate_vertices();
+    recalculate_all_except_vertices();
+    Tesselation result{.vertices = vertices_, .indices = indices_, .normals = normals_, .tex_uv1 = tex_uv1_};
+    Vector3* v = result.vertices.ptrw();
+    int n = result.vertices.size();
+    for (int i = 0; i < n; ++i) {
+      v[i] -= center;
+    }
+    return result;
+  });
+
+  // translated template is written into storage of previous vertices, mesh reset to the same tesselation doesn't
+  // allocate it again
+  int n = _tesselation->vertices.size();
+  vertices_.resize(n);
+  const Vector3* t = _tesselation->vertices.ptr();
+  Vector3* v = vertices_.ptrw();
+  for (int i = 0; i < n; ++i) {
+    v[i] = t[i] + center;
+  }
+  indices_ = _tesselation->indices;
+  normals_ = _tesselation->normals;
+  tex_uv1_ = _tesselation->tex_uv1;
+  calculate_tangents();
+  calculate_colors();
+  calculate_tex_uv2();
+  calculate_color_custom();
+  calculate_bones_weights();
+}
+
+void SotaMesh::tesselate_fan(const std::vector<Vector3>& corners, Vector3 center, int level) {
+  int sides = corners.size();
+  int n = 1 << (level - 1);
+  int stride = n + 1;
+  LatticeMesher mesher(_indexed, 1 + sides * stride * stride);
+  for (int side = 0; side < sides; ++side) {
+    auto key = [side, sides, n, stride](FanPoint p) {
+      if (p.s == 0 && p.t == 0) {
+        return 0;
+      }
+      // point of ray to next corner belongs to next triangle of fan
+      if (p.s == 0) {
+        return 1 + (side + 1) % sides * stride * stride + p.t * stride;
+      }
+      return 1 + side * stride * stride + p.s * stride + p.t;
+    };
+    tesselate_into_triangles(mesher, key, FanPoint{corners[side], n, 0},
+                             FanPoint{corners[(side + 1) % sides], 0, n}, FanPoint{center, 0, 0}, level);
+  }
+  mesher.finish(vertices_, indices_);
+}
+
+void SotaMesh::weld_vertices() {
+  if (!_indexed) {
+    return;
+  }
+  std::map<DiscreteVertex, int> welded;
+  Vector3Array unique_vertices;
+  indices_.clear();
+  for (const auto& v : vertices_) {
+    auto [it, inserted] =
+        welded.try_emplace(VertexToNormalDiscretizer::get_discrete_vertex(v, EPSILON), unique_vertices.size());
+    if (inserted) {
+      unique_vertices.push_back(v);
+    }
+    indices_.push_back(it->second);
+  }
+  vertices_ = unique_vertices;
+}
+
+void SotaMesh::append_triangle(Vector3 a, Vector3 b, Vector3 c) {
+  if (_indexed) {
+    int first = vertices_.size();
+    indices_.append_array({first, first + 1, first + 2});
+  }
+  vertices_.append_array({a, b, c});
+}
+
+void SotaMesh::fit_to_lod_source(const SotaMesh& source) {
+  if (source.vertices_.is_empty()) {
+    return;
+  }
+  Vector3 center = _base_ngon->center();
+  Vector3 normal = _base_ngon->normal();
+  std::vector<Vector3> corners = _base_ngon->points();
+  int sides = corners.size();
+
+  // points of source lattice are not closer to each other than R / divisions
+  float step = get_R() / (source._divisions * 4);
+  auto projected = [center, normal](Vector3 v) { return v - normal * normal.dot(v - center); };
+  auto discrete = [step](Vector3 p) { return VertexToNormalDiscretizer::get_discrete_vertex(p, step); };
+  // position of point on side of base polygon, negative if point doesn't lie on it
+  auto position_on_side = [&corners, sides, step](int side, Vector3 p) -> float {
+    Vector3 a = corners[side];
+    Vector3 ab = corners[(side + 1) % sides] - a;
+    float t = (p - a).dot(ab) / ab.length_squared();
+    if (t > -EPSILON && t < 1 + EPSILON && (a + ab * t).distance_to(p) < step) {
+      return std::clamp<float>(t, 0, 1);
+    }
+    return -1;
+  };
+
+  // frame vertices share projection with vertices of surface, so the highest one is taken
+  std::map<DiscreteVertex, std::pair<Vector3, float>> heights;
+  for (const Vector3& v : source.vertices_) {
+    Vector3 p = projected(v);
+    float h = normal.dot(v - center);
+    auto [it, inserted] = heights.try_emplace(discrete(p), p, h);
+    it->second.second = std::max(it->second.second, h);
+  }
+  std::vector<std::vector<std::pair<float, Vector3>>> border(sides);
+  for (const auto& entry : heights) {
+    Vector3 p = entry.second.first;
+    for (int side = 0; side < sides; ++side) {
+      if (float t = position_on_side(side, p); t >= 0) {
+        border[side].emplace_back(t, p);
+      }
+    }
+  }
+  for (auto& points : border) {
+    std::sort(points.begin(), points.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  }
+
+  Vector3Array soup;
+  int n = _indexed ? indices_.size() : vertices_.size();
+  for (int i = 0; i < n; i += 3) {
+    Vector3 triangle[3];
+    for (int j = 0; j < 3; ++j) {
+      triangle[j] = vertices_[_indexed ? indices_[i + j] : i + j];
+    }
+    bool split = false;
+    for (int j = 0; j < 3 && !split; ++j) {
+      Vector3 a = triangle[j];
+      Vector3 b = triangle[(j + 1) % 3];
+      Vector3 c = triangle[(j + 2) % 3];
+      int side = 0;
+      float t_a = -1;
+      float t_b = -1;
+      for (; side < sides; ++side) {
+        t_a = position_on_side(side, a);
+        t_b = position_on_side(side, b);
+        if (t_a >= 0 && t_b >= 0) {
+          break;
+        }
+      }
+      if (side == sides) {
+        continue;
+      }
+      // fan from opposite vertex to border vertices of source lying between a and b
+      std::vector<Vector3> between;
+      for (const auto& [t, p] : border[side]) {
+        if (t > std::min(t_a, t_b) + EPSILON && t < std::max(t_a, t_b) - EPSILON) {
+          between.push_back(p);
+        }
+      }
+      if (t_a > t_b) {
+        std::reverse(between.begin(), between.end());
+      }
+      Vector3 previous = a;
+      for (Vector3 p : between) {
+        soup.append_array({previous, p, c});
+        previous = p;
+      }
+      soup.append_array({previous, b, c});
+      split = true;
+    }
+    if (!split) {
+      soup.append_array({triangle[0], triangle[1], triangle[2]});
+    }
+  }
+
+  // clipped tiles are shifted by half of step of their own lattice, so some of their vertices take height of the
+  // closest vertex of source. It's searched in buckets of cell size around vertex, ring by ring
+  using HeightsIt = decltype(heights)::const_iterator;
+  float cell = get_R() / source._divisions;
+  std::map<DiscreteVertex, std::vector<HeightsIt>> buckets;
+  for (auto it = heights.cbegin(); it != heights.cend(); ++it) {
+    buckets[VertexToNormalDiscretizer::get_discrete_vertex(it->second.first, cell)].push_back(it);
+  }
+  auto closest = [&heights, &buckets, cell](Vector3 p) {
+    DiscreteVertex origin = VertexToNormalDiscretizer::get_discrete_vertex(p, cell);
+    HeightsIt best = heights.cend();
+    float best_distance = 0;
+    for (int ring = 0;; ++ring) {
+      for (int dx = -ring; dx <= ring; ++dx) {
+        for (int dy = -ring; dy <= ring; ++dy) {
+          for (int dz = -ring; dz <= ring; ++dz) {
+            if (std::max({std::abs(dx), std::abs(dy), std::abs(dz)}) != ring) {
+              continue;
+            }
+            auto bucket = buckets.find(origin + DiscreteVertex(dx, dy, dz));
+            if (bucket == buckets.end()) {
+              continue;
+            }
+            for (HeightsIt it : bucket->second) {
+              float distance = p.distance_squared_to(it->second.first);
+              // ties are resolved by order of vertices in map, so result doesn't depend on order of buckets
+              if (best == heights.cend() || distance < best_distance ||
+                  (distance == best_distance && it->first < best->first)) {
+                best = it;
+                best_distance = distance;
+              }
+            }
+          }
+        }
+      }
+      // vertices of further rings are at least ring cells away
+      if (best != heights.cend() && best_distance < ring * cell * ring * cell) {
+        return best;
+      }
+    }
+  };
+
+  Vector3* v = soup.ptrw();
+  int size = soup.size();
+  for (int i = 0; i < size; ++i) {
+    Vector3 p = projected(v[i]);
+    HeightsIt it = heights.find(discrete(p));
+    if (it == heights.cend()) {
+      it = closest(p);
+    }
+    v[i] = p + normal * it->second.second;
+  }
+
+  vertices_ = soup;
+  weld_vertices();
+  recalculate_all_except_vertices();
+}
+
+DecimationStats SotaMesh::decimate_planar(float tolerance) {
+  bool indexed = _indexed;
+  if (!indexed) {
+    // decimation works on shared vertices, so triangle soup is welded first
+    _indexed = true;
+    weld_vertices();
+  }
+  DecimationStats stats = PlanarDecimator(tolerance).decimate(vertices_, indices_);
+  if (!indexed) {
+    Vector3Array soup;
+    soup.resize(indices_.size());
+    Vector3* v = soup.ptrw();
+    int n = indices_.size();
+    for (int i = 0; i < n; ++i) {
+      v[i] = vertices_[indices_[i]];
+    }
+    vertices_ = soup;
+    _indexed = false;
+  }
+  _decimated = _decimated || stats.triangles_after < stats.triangles_before;
+  _decimation_stats = stats;
+  recalculate_all_except_vertices();
+  return stats;
 }
 
 void SotaMesh::calculate_normals() {
-  normals_.clear();
+  _normals_dirty = false;
+  if (!has_attribute(MeshAttribute::Normal)) {
+    normals_.clear();
+    return;
+  }
+  const Vector3* vertices = vertices_.ptr();
   int n = vertices_.size();
+  normals_.resize(n);
+  Vector3* normals = normals_.ptrw();
+  // shared vertices get smooth normals, see set_indexed
+  if (_indexed) {
+    // area weighted sum of normals of adjacent faces
+    std::fill(normals, normals + n, Vector3(0, 0, 0));
+    const int* indices = indices_.ptr();
+    int indices_size = indices_.size();
+    for (int i = 0; i < indices_size; i += 3) {
+      const Vector3& p0 = vertices[indices[i]];
+      const Vector3& p1 = vertices[indices[i + 1]];
+      const Vector3& p2 = vertices[indices[i + 2]];
+
+      Vector3 normal = (p0 - p1).cross(p2 - p1);
+      normals[indices[i]] += normal;
+      normals[indices[i + 1]] += normal;
+      normals[indices[i + 2]] += normal;
+    }
+    for (int i = 0; i < n; ++i) {
+      normals[i] = normals[i].normalized();
+    }
+    return;
+  }
+
   for (int i = 0; i < n; i += 3) {
-    const Vector3& p0 = vertices_[i];
-    const Vector3& p1 = vertices_[i + 1];
-    const Vector3& p2 = vertices_[i + 2];
+    const Vector3& p0 = vertices[i];
+    const Vector3& p1 = vertices[i + 1];
+    const Vector3& p2 = vertices[i + 2];
 
     Vector3 normal = (p0 - p1).cross(p2 - p1);
     normal = normal.normalized();
 
-    normals_.insert(normals_.end(), {normal, normal, normal});
+    normals[i] = normal;
+    normals[i + 1] = normal;
+    normals[i + 2] = normal;
   }
 }
 
-void SotaMesh::calculate_tangents() { tangents_ = DummyMesher::calculate_tangents(vertices_.size()); }
+void SotaMesh::calculate_tangents() {
+  tangents_ =
+      has_attribute(MeshAttribute::Tangent) ? DummyMesher::calculate_tangents(vertices_.size()) : TangentsArray();
+}
 
-void SotaMesh::calculate_colors() { colors_ = DummyMesher::calculate_colors(vertices_.size()); }
+void SotaMesh::calculate_colors() {
+  colors_ = has_attribute(MeshAttribute::Color) ? DummyMesher::calculate_colors(vertices_.size()) : ColorsArray();
+}
 
 void SotaMesh::calculate_indices() {
+  if (_indexed) {
+    // index buffer is built together with vertices, see weld_vertices and append_triangle
+    return;
+  }
   indices_.clear();
   int n = vertices_.size();
   for (int i = 0; i < n; i += 3) {
     indices_.append_array({i, i + 1, i + 2});
   }
 }
-void SotaMesh::calculate_tex_uv2() { tex_uv2_ = DummyMesher::calculate_tex_uv2(vertices_.size()); }
+void SotaMesh::calculate_tex_uv2() {
+  tex_uv2_ = has_attribute(MeshAttribute::TexUV2) ? DummyMesher::calculate_tex_uv2(vertices_.size()) : Vector2Array();
+}
 
 void SotaMesh::calculate_color_custom() {
-  color_custom0_ = DummyMesher::calculate_color_custom0(vertices_.size());
-  color_custom1_ = DummyMesher::calculate_color_custom0(vertices_.size());
-  color_custom2_ = DummyMesher::calculate_color_custom0(vertices_.size());
-  color_custom3_ = DummyMesher::calculate_color_custom0(vertices_.size());
+  int n = vertices_.size();
+  color_custom0_ = has_attribute(MeshAttribute::Custom0) ? DummyMesher::calculate_color_custom0(n) : ByteArray();
+  color_custom1_ = has_attribute(MeshAttribute::Custom1) ? DummyMesher::calculate_color_custom1(n) : ByteArray();
+  color_custom2_ = has_attribute(MeshAttribute::Custom2) ? DummyMesher::calculate_color_custom2(n) : ByteArray();
+  color_custom3_ = has_attribute(MeshAttribute::Custom3) ? DummyMesher::calculate_color_custom3(n) : ByteArray();
 }
 
 void SotaMesh::calculate_bones_weights() {
+  if (!has_attribute(MeshAttribute::BonesWeights)) {
+    bones_ = IntArray();
+    weights_ = WeightsArray();
+    return;
+  }
   bones_ = DummyMesher::calculate_bones(vertices_.size());
   weights_ = DummyMesher::calculate_weights(vertices_.size());
 }
 
 #ifdef SOTA_GDEXTENSION
 Array SotaMesh::_create_mesh_array() const {
+  // derived attributes are lazily calculated cache of vertices
+  const_cast<SotaMesh*>(this)->recalculate_dirty();
+  // attributes excluded by mask are passed as null, so they don't contribute to surface format
+  auto optional = [this](MeshAttribute attribute, const Variant& array) -> Variant {
+    return has_attribute(attribute) ? array : Variant();
+  };
   Array res;
   res.append(vertices_);
-  res.append(normals_to_godot_fmt());
-  res.append(tangents_);
-  res.append(colors_);
-  res.append(tex_uv1_);
-  res.append(tex_uv2_);
-  res.append(color_custom0_);
-  res.append(color_custom1_);
-  res.append(color_custom2_);
-  res.append(color_custom3_);
-  res.append(bones_);
-  res.append(weights_);
+  res.append(optional(MeshAttribute::Normal, normals_));
+  res.append(optional(MeshAttribute::Tangent, tangents_));
+  res.append(optional(MeshAttribute::Color, colors_));
+  res.append(optional(MeshAttribute::TexUV, tex_uv1_));
+  res.append(optional(MeshAttribute::TexUV2, tex_uv2_));
+  res.append(optional(MeshAttribute::Custom0, color_custom0_));
+  res.append(optional(MeshAttribute::Custom1, color_custom1_));
+  res.append(optional(MeshAttribute::Custom2, color_custom2_));
+  res.append(optional(MeshAttribute::Custom3, color_custom3_));
+  res.append(optional(MeshAttribute::BonesWeights, bones_));
+  res.append(optional(MeshAttribute::BonesWeights, weights_));
   res.append(indices_);
   return res;
 }
 #else
 void SotaMesh::_create_mesh_array(Array& res) const {
+  // derived attributes are lazily calculated cache of vertices
+  const_cast<SotaMesh*>(this)->recalculate_dirty();
   res[RS::ARRAY_VERTEX] = vertices_;
-  res[RS::ARRAY_NORMAL] = normals_to_godot_fmt();
-  res[RS::ARRAY_TANGENT] = tangents_;
-  res[RS::ARRAY_TEX_UV] = tex_uv1_;
+  if (has_attribute(MeshAttribute::Normal)) {
+    res[RS::ARRAY_NORMAL] = normals_;
+  }
+  if (has_attribute(MeshAttribute::Tangent)) {
+    res[RS::ARRAY_TANGENT] = tangents_;
+  }
+  if (has_attribute(MeshAttribute::Color)) {
+    res[RS::ARRAY_COLOR] = colors_;
+  }
+  if (has_attribute(MeshAttribute::TexUV)) {
+    res[RS::ARRAY_TEX_UV] = tex_uv1_;
+  }
+  if (has_attribute(MeshAttribute::TexUV2)) {
+    res[RS::ARRAY_TEX_UV2] = tex_uv2_;
+  }
+  if (has_attribute(MeshAttribute::Custom0)) {
+    res[RS::ARRAY_CUSTOM0] = color_custom0_;
+  }
+  if (has_attribute(MeshAttribute::Custom1)) {
+    res[RS::ARRAY_CUSTOM1] = color_custom1_;
+  }
+  if (has_attribute(MeshAttribute::Custom2)) {
+    res[RS::ARRAY_CUSTOM2] = color_custom2_;
+  }
+  if (has_attribute(MeshAttribute::Custom3)) {
+    res[RS::ARRAY_CUSTOM3] = color_custom3_;
+  }
+  if (has_attribute(MeshAttribute::BonesWeights)) {
+    res[RS::ARRAY_BONES] = bones_;
+    res[RS::ARRAY_WEIGHTS] = weights_;
+  }
   res[RS::ARRAY_INDEX] = indices_;
 }
 #endif
 
 void SotaMesh::recalculate_all_except_vertices() {
+  _surface_layout_changed = true;
   calculate_indices();
   calculate_normals();
-  calculate_tex_uv1();
+  calculate_tex_uv1_if_needed();
   calculate_tangents();
   calculate_colors();
   calculate_tex_uv2();
@@ -122,22 +569,147 @@ void SotaMesh::recalculate_all_except_vertices() {
   calculate_bones_weights();
 }
 
+void SotaMesh::calculate_tex_uv1_if_needed() {
+  _tex_uv1_dirty = false;
+  if (has_attribute(MeshAttribute::TexUV)) {
+    calculate_tex_uv1();
+  } else {
+    tex_uv1_.clear();
+  }
+}
+
 Vector3Array SotaMesh::get_vertices() const { return vertices_; }
 
+Vector3Array& SotaMesh::get_normals() {
+  if (_normals_dirty) {
+    calculate_normals();
+  }
+  return normals_;
+}
+
 void SotaMesh::set_vertices(Vector3Array vertices) {
+  if (vertices.size() == vertices_.size()) {
+    // same topology, only positions are changed
+    vertices_ = vertices;
+    _normals_dirty = true;
+    _tex_uv1_dirty = true;
+    upload();
+    return;
+  }
+  // index buffer doesn't match new vertices, they are triangle soup
   vertices_ = vertices;
+  weld_vertices();
   recalculate_all_except_vertices();
-  request_update();
+  upload();
+}
+
+void SotaMesh::update() {
+  recalculate_dirty();
+  upload();
+}
+
+void SotaMesh::upload() {
+  if (_chunk) {
+    // surface of tile is a part of surface of chunk
+    recalculate_dirty();
+    _chunk->update_tile(_chunk_index);
+    return;
+  }
+  if (!_direct_upload) {
+    request_update();
+    return;
+  }
+  bool attributes_changed = _tex_uv1_dirty || _surface_layout_changed;
+  recalculate_dirty();
+  if (_surface_layout_changed || !upload_regions(attributes_changed)) {
+    upload_surface();
+  }
+  // regions don't update bounds of surface
+  RenderingServer::get_singleton()->mesh_set_custom_aabb(get_rid(), calculate_aabb());
+}
+
+Array SotaMesh::mesh_arrays() const {
+#ifdef SOTA_GDEXTENSION
+  return _create_mesh_array();
+#else
+  Array arrays;
+  arrays.resize(RenderingServer::ARRAY_MAX);
+  _create_mesh_array(arrays);
+  return arrays;
+#endif
 }
 
-Vector3Array SotaMesh::normals_to_godot_fmt() const {
-  Vector3Array normals;
-  for (const auto& n : normals_) {
-    normals.append(n);
+int64_t SotaMesh::surface_format() const {
+  static const std::pair<MeshAttribute, int64_t> attribute_formats[] = {
+      {MeshAttribute::Normal, RenderingServer::ARRAY_FORMAT_NORMAL},
+      {MeshAttribute::Tangent, RenderingServer::ARRAY_FORMAT_TANGENT},
+      {MeshAttribute::Color, RenderingServer::ARRAY_FORMAT_COLOR},
+      {MeshAttribute::TexUV, RenderingServer::ARRAY_FORMAT_TEX_UV},
+      {MeshAttribute::TexUV2, RenderingServer::ARRAY_FORMAT_TEX_UV2},
+      {MeshAttribute::Custom0, RenderingServer::ARRAY_FORMAT_CUSTOM0},
+      {MeshAttribute::Custom1, RenderingServer::ARRAY_FORMAT_CUSTOM1},
+      {MeshAttribute::Custom2, RenderingServer::ARRAY_FORMAT_CUSTOM2},
+      {MeshAttribute::Custom3, RenderingServer::ARRAY_FORMAT_CUSTOM3},
+      {MeshAttribute::BonesWeights, RenderingServer::ARRAY_FORMAT_BONES | RenderingServer::ARRAY_FORMAT_WEIGHTS},
+  };
+  int64_t format = RenderingServer::ARRAY_FORMAT_VERTEX | RenderingServer::ARRAY_FORMAT_INDEX;
+  for (const auto& [attribute, attribute_format] : attribute_formats) {
+    if (has_attribute(attribute)) {
+      format |= attribute_format;
+    }
+  }
+  return format;
+}
+
+AABB SotaMesh::calculate_aabb() const {
+  int n = vertices_.size();
+  if (n == 0) {
+    return AABB();
+  }
+  const Vector3* vertices = vertices_.ptr();
+  AABB aabb(vertices[0], Vector3(0, 0, 0));
+  for (int i = 1; i < n; ++i) {
+    aabb.expand_to(vertices[i]);
   }
-  return normals;
+  return aabb;
 }
 
-void SotaMesh::update() { request_update(); }
+void SotaMesh::upload_surface() {
+  RenderingServer* rs = RenderingServer::get_singleton();
+  RID rid = get_rid();
+  rs->mesh_clear(rid);
+  rs->mesh_add_surface_from_arrays(rid, RenderingServer::PRIMITIVE_TRIANGLES, mesh_arrays());
+  Ref<Material> material = get_material();
+  rs->mesh_surface_set_material(rid, 0, material.ptr() ? material->get_rid() : RID());
+  _surface_layout_changed = false;
+}
+
+bool SotaMesh::upload_regions(bool attributes_changed) {
+  RenderingServer* rs = RenderingServer::get_singleton();
+  int64_t format = surface_format();
+  if (format & RenderingServer::ARRAY_FORMAT_TANGENT) {
+    // tangents are interleaved with normals, leave their encoding to engine
+    return false;
+  }
+  const int64_t uv_formats = RenderingServer::ARRAY_FORMAT_TEX_UV | RenderingServer::ARRAY_FORMAT_TEX_UV2;
+  const int64_t attribute_formats = uv_formats | RenderingServer::ARRAY_FORMAT_COLOR |
+                                    RenderingServer::ARRAY_FORMAT_CUSTOM0 | RenderingServer::ARRAY_FORMAT_CUSTOM1 |
+                                    RenderingServer::ARRAY_FORMAT_CUSTOM2 | RenderingServer::ARRAY_FORMAT_CUSTOM3;
+  bool update_attributes = attributes_changed && (format & attribute_formats);
+  if (update_attributes && (format & attribute_formats & ~uv_formats)) {
+    // only UVs are derived from positions, other attributes of region would have to be encoded too
+    return false;
+  }
+
+  int n = vertices_.size();
+  SurfaceRegions regions(get_rid(), format, n);
+  regions.update_vertices(0, n, vertices_.ptr(),
+                          (format & RenderingServer::ARRAY_FORMAT_NORMAL) ? normals_.ptr() : nullptr);
+  if (update_attributes) {
+    regions.update_attributes(0, n, (format & RenderingServer::ARRAY_FORMAT_TEX_UV) ? tex_uv1_.ptr() : nullptr,
+                              (format & RenderingServer::ARRAY_FORMAT_TEX_UV2) ? tex_uv2_.ptr() : nullptr, nullptr);
+  }
+  return true;
+}
 
 }  // namespace sota
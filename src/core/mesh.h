@@ -1,23 +1,53 @@
 #pragma once
 
-#include <memory>   // for unique_ptr
+#include <memory>   // for shared_ptr, unique_ptr
+#include <span>     // for span
 #include <utility>  // for move, swap
 #include <vector>   // for vector
 
+#include "core/planar_decimator.h"   // for DecimationStats
+#include "core/tesselation_cache.h"  // for Tesselation, TesselationKey
 #include "mesh.h"
-#include "primitives/edge.h"      // for Edge
-#include "primitives/face.h"      // for Face
-#include "primitives/polygon.h"   // for RegularPolygon
-#include "primitives/triangle.h"  // for Triangle
-#include "tal/arrays.h"           // for Vector3Array
-#include "tal/mesh.h"             // for PrimitiveMesh
-#include "tal/vector3.h"          // for Vector3
+#include "primitives/edge.h"       // for Edge
+#include "primitives/face.h"       // for Face
+#include "primitives/polygon.h"    // for RegularPolygon
+#include "primitives/triangle.h"   // for Triangle
+#include "tal/arrays.h"            // for Vector3Array
+#include "tal/mesh.h"              // for PrimitiveMesh
+#include "tal/reference.h"         // for Ref
+#include "tal/rendering_server.h"  // for AABB
+#include "tal/vector3.h"           // for Vector3
 
 namespace sota {
+class Chunk;
 
 enum class TesselationMode { Iterative = 0, Recursive };
 enum class Orientation { Plane = 0, Polyhedron };
 
+/**
+ * @brief Optional vertex attributes of mesh. Vertices and indices are always generated. Values are bit flags, mask of
+ * them defines which arrays are allocated, calculated and uploaded to RenderingServer
+ */
+enum class MeshAttribute : int {
+  Normal = 1 << 0,
+  Tangent = 1 << 1,
+  Color = 1 << 2,
+  TexUV = 1 << 3,
+  TexUV2 = 1 << 4,
+  Custom0 = 1 << 5,
+  Custom1 = 1 << 6,
+  Custom2 = 1 << 7,
+  Custom3 = 1 << 8,
+  BonesWeights = 1 << 9,
+};
+
+// attributes used by shaders shipped with demo project
+constexpr int DEFAULT_MESH_ATTRIBUTES =
+    static_cast<int>(MeshAttribute::Normal) | static_cast<int>(MeshAttribute::TexUV);
+// hint string for inspector, order matches MeshAttribute values
+constexpr const char* MESH_ATTRIBUTES_HINT =
+    "Normal,Tangent,Color,UV,UV2,Custom0,Custom1,Custom2,Custom3,Bones/Weights";
+
 /**
  * @brief Base class for all meshes
  *
@@ -39,6 +69,11 @@ class SotaMesh : public PrimitiveMesh {
   int get_id() const { return _id; }
 
   void init();
+  /**
+   * @brief Tesselates mesh like init() without sending it to RenderingServer, so it may run on worker thread. Mesh is
+   * uploaded by later update() or init()
+   */
+  void build();
   void update();
 
   const RegularPolygon& base() const { return *_base_ngon.get(); }
@@ -61,17 +96,91 @@ class SotaMesh : public PrimitiveMesh {
   void recalculate_all_except_vertices();
   /**
    * @brief Calculate normals. Usually used when positions of vertices are changed but order remains the same
+   *
+   * Scalar loop over raw pointers, normals are written in place into storage resized once per call. Vertices are kept
+   * as array of structs for Godot arrays and mesh processors, so SIMD kernel has to transpose them on every call and
+   * gains only about 20% here
    */
   void calculate_normals();
 
   Vector3Array get_vertices() const;
-  std::vector<Vector3>& get_normals() { return normals_; }
+  /**
+   * @brief Normals in format consumed by RenderingServer. Smoothing of normals writes to them in place
+   */
+  Vector3Array& get_normals();
 
+  /**
+   * @brief Replaces vertices. If number of vertices is the same, they are treated as moved vertices, see edit_vertices.
+   * Otherwise they are triangle soup, which is welded in indexed mode
+   */
   void set_vertices(Vector3Array vertices);
 
+  /**
+   * @brief Scoped in-place edit of vertex positions. Number and order of vertices must not change. Attributes derived
+   * from positions are only marked dirty and recalculated once, before upload
+   *
+   * @param edit - callable taking std::span<Vector3>
+   */
+  template <typename F>
+  void edit_vertices(F&& edit) {
+    edit(std::span<Vector3>(vertices_.ptrw(), vertices_.size()));
+    _normals_dirty = true;
+    _tex_uv1_dirty = true;
+  }
+
+  /**
+   * @brief Merges nearly coplanar triangles, see PlanarDecimator. Border vertices of mesh are kept as is
+   *
+   * @param tolerance - max distance of removed vertex to plane of triangles replacing it
+   */
+  DecimationStats decimate_planar(float tolerance);
+  // stats of the last decimation since mesh was built
+  const DecimationStats& decimation_stats() const { return _decimation_stats; }
+
   void set_orientation(Orientation p_orientation) { _orientation = p_orientation; }
   void set_tesselation_mode(TesselationMode p_tesselation_mode) { _tesselation_mode = p_tesselation_mode; }
 
+  /**
+   * @brief Property shared with Godot inspector. In indexed mode every lattice point is stored once and triangles are
+   * described by index buffer. Otherwise mesh is a triangle soup
+   *
+   * Shared vertex has single normal, so indexed mesh is smooth shaded: normal of vertex is average of normals of
+   * triangles around it. Triangle soup is flat shaded
+   */
+  void set_indexed(const bool p_indexed);
+  bool is_indexed() const;
+
+  /**
+   * @brief Property shared with Godot inspector. Mask of MeshAttribute values
+   */
+  void set_attributes(const int p_attributes);
+  int get_attributes() const;
+  bool has_attribute(MeshAttribute attribute) const { return _attributes & static_cast<int>(attribute); }
+
+  /**
+   * @brief Property shared with Godot inspector. If set, geometry is written straight into RenderingServer surface of
+   * mesh instead of deferred rebuild via _create_mesh_array. If only positions and normals are changed, just vertex
+   * region of surface is updated
+   */
+  void set_direct_upload(const bool p_direct_upload);
+  bool is_direct_upload() const;
+
+  /**
+   * @brief Builds the same tile with lower number of divisions and heights of this mesh. Returns null reference if
+   * type of mesh doesn't support levels of detail or mesh is decimated. Levels of detail are drawn by chunks, so they
+   * aren't uploaded
+   */
+  virtual Ref<SotaMesh> make_lod(int divisions) const { return Ref<SotaMesh>(); }
+
+  /**
+   * @brief Makes mesh a part of merged surface of chunk. Uploads of mesh update its range of chunk surface instead of
+   * own surface. Null chunk detaches mesh
+   */
+  void set_chunk(Chunk* chunk, int index) {
+    _chunk = chunk;
+    _chunk_index = index;
+  }
+
   Orientation get_orientation() const { return _orientation; }
   TesselationMode get_tesselation_mode() const { return _tesselation_mode; }
 
@@ -102,9 +211,23 @@ class SotaMesh : public PrimitiveMesh {
 
   Orientation _orientation{Orientation::Plane};
   TesselationMode _tesselation_mode{TesselationMode::Iterative};
+  bool _indexed{false};
+  int _attributes{DEFAULT_MESH_ATTRIBUTES};
+  bool _direct_upload{false};
+
+  // vertices don't form regular lattice of divisions anymore
+  bool _decimated{false};
+  DecimationStats _decimation_stats;
+
+  // template of flat tile, kept while mesh is built from it, see TesselationCache
+  std::shared_ptr<const Tesselation> _tesselation;
+
+  // set by edit_vertices, attributes are recalculated by recalculate_dirty
+  bool _normals_dirty{false};
+  bool _tex_uv1_dirty{false};
 
   Vector3Array vertices_;
-  std::vector<Vector3> normals_;
+  Vector3Array normals_;
   TangentsArray tangents_;
   ColorsArray colors_;
   Vector2Array tex_uv1_;
@@ -120,8 +243,29 @@ class SotaMesh : public PrimitiveMesh {
   static void _bind_methods();
   virtual void init_impl() = 0;
 
+  /**
+   * @brief Builds vertices of tile from scratch (and index buffer in indexed mode)
+   */
+  virtual void calculate_vertices() = 0;
+
+  /**
+   * @brief Parameters defining tesselation up to translation. Subclasses extend it with their own options
+   */
+  virtual TesselationKey tesselation_key() const;
+
+  /**
+   * @brief Builds all arrays of tile. Flat tiles are translated copies of template shared via TesselationCache, other
+   * tiles are calculated from scratch
+   */
+  void init_from_template();
+
   void calculate_tangents();
   void calculate_colors();
+  void calculate_tex_uv1_if_needed();
+  /**
+   * @brief Recalculates attributes marked dirty after editing of vertices
+   */
+  void recalculate_dirty();
   /**
    * @brief Mapping of texture is a mandatory method to define by subclass.
    */
@@ -132,15 +276,36 @@ class SotaMesh : public PrimitiveMesh {
   void calculate_bones_weights();
 
   /**
-   * @brief Recursively splits triangle into 4 smaller triangles and appends to vertices.
+   * @brief Sends current state of mesh to RenderingServer using selected path
+   */
+  void upload();
+
+  /**
+   * @brief Builds vertices of fan of triangles (corners[i], corners[i + 1], center). Every triangle is recursively
+   * split into 4 smaller triangles. In indexed mode triangles share vertices, index buffer is built as well
    *
-   * @param a - vertice of triangle
-   * @param b - vertice of triangle
-   * @param c - vertice of triangle
-   * @param level - required levels of recursion. Level 1 means no recursion, i.e. 1 triangle will be added. On level 2
+   * @param level - required levels of recursion. Level 1 means no recursion, i.e. 1 triangle per side. On level 2
    * - 4 triangles. Level 3 - 16 triangles and so on
    */
-  void tesselate_into_triangles(Vector3 a, Vector3 b, Vector3 c, int level);
+  void tesselate_fan(const std::vector<Vector3>& corners, Vector3 center, int level);
+
+  /**
+   * @brief Merges coincident vertices of triangle soup and builds index buffer. Does nothing if mesh is not indexed.
+   * Tesselation emits shared vertices itself, welding is needed for triangles not coming from lattice
+   */
+  void weld_vertices();
+
+  /**
+   * @brief Appends triangle with its own (not shared) vertices. Index buffer is extended in indexed mode
+   */
+  void append_triangle(Vector3 a, Vector3 b, Vector3 c);
+
+  /**
+   * @brief Turns freshly tesselated flat mesh into level of detail of finer source mesh of the same tile. Heights of
+   * vertices are taken from source. Triangles adjacent to border of base polygon are split at border vertices of
+   * source, so border is the same on all levels and there are no cracks between tiles with different levels
+   */
+  void fit_to_lod_source(const SotaMesh& source);
 
   // negative offset means direction negative to base hex normal
   void add_face_to_base_edge(Edge e, float offset) {
@@ -154,8 +319,8 @@ class SotaMesh : public PrimitiveMesh {
     }
     auto [first_triangle, second_triangle] = Face(edge1, edge2).get_triangles();
 
-    vertices_.append_array(first_triangle.to_godot_array());
-    vertices_.append_array(second_triangle.to_godot_array());
+    append_triangle(first_triangle.a, first_triangle.b, first_triangle.c);
+    append_triangle(second_triangle.a, second_triangle.b, second_triangle.c);
   }
 
   void add_faces(float offset) {
@@ -176,7 +341,19 @@ class SotaMesh : public PrimitiveMesh {
   }
 
  private:
-  Vector3Array normals_to_godot_fmt() const;
+  friend class Chunk;
+
+  Chunk* _chunk{nullptr};
+  int _chunk_index{0};
+
+  // number of vertices, indices or set of attributes changed since last direct upload of surface
+  bool _surface_layout_changed{true};
+
+  Array mesh_arrays() const;
+  int64_t surface_format() const;
+  AABB calculate_aabb() const;
+  void upload_surface();
+  bool upload_regions(bool attributes_changed);
 };
 
 }  // namespace sota
@@ -0,0 +1,67 @@
+#include "core/noise_cache.h"
+
+#include <cstdint>  // for uint64_t
+#include <utility>  // for pair
+
+#include "core/parallel.h"  // for parallel_for
+
+namespace sota {
+
+size_t NoiseCache::DiscreteVertexHash::operator()(const DiscreteVertex& v) const {
+  uint64_t h = static_cast<uint32_t>(v.x);
+  h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(v.y);
+  h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(v.z);
+  return h ^ (h >> 29);
+}
+
+void NoiseCache::reset(Ref<FastNoiseLite> noise, Orientation orientation, float step) {
+  _noise = noise;
+  _orientation = orientation;
+  _step = step;
+  clear();
+}
+
+void NoiseCache::clear() {
+  // clear() keeps buckets, swap releases them as well
+  std::unordered_map<DiscreteVertex, float, DiscreteVertexHash>().swap(_values);
+}
+
+void NoiseCache::sample(const std::vector<Vector3Array>& points, int threads_count) {
+  if (!_noise.ptr()) {
+    return;
+  }
+  // references to elements of unordered_map stay valid on rehash, so values are written in place by workers
+  std::vector<std::pair<Vector3, float*>> pending;
+  for (const Vector3Array& array : points) {
+    const Vector3* p = array.ptr();
+    for (int i = 0; i < array.size(); ++i) {
+      auto [it, inserted] = _values.try_emplace(key(p[i]), 0.0f);
+      if (inserted) {
+        pending.push_back({p[i], &it->second});
+      }
+    }
+  }
+  parallel_for(pending.size(), threads_count,
+               [this, &pending](int i) { *pending[i].second = sample_noise(pending[i].first); });
+}
+
+float NoiseCache::get(Vector3 point) const {
+  if (!_noise.ptr()) {
+    return 0.0;
+  }
+  auto it = _values.find(key(point));
+  return it != _values.end() ? it->second : sample_noise(point);
+}
+
+DiscreteVertex NoiseCache::key(Vector3 point) const {
+  if (_orientation == Orientation::Plane) {
+    point.y = 0;
+  }
+  return VertexToNormalDiscretizer::get_discrete_vertex(point, _step);
+}
+
+float NoiseCache::sample_noise(Vector3 point) const {
+  return _orientation == Orientation::Plane ? _noise->get_noise_2d(point.x, point.z) : _noise->get_noise_3dv(point);
+}
+
+}  // namespace sota
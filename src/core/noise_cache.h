@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>        // for size_t
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "core/mesh.h"         // for Orientation
+#include "misc/discretizer.h"  // for DiscreteVertex
+#include "tal/arrays.h"        // for Vector3Array
+#include "tal/noise.h"         // for FastNoiseLite
+#include "tal/reference.h"     // for Ref
+#include "tal/vector3.h"       // for Vector3
+
+namespace sota {
+
+/**
+ * @brief Values of noise at vertices of tiles keyed by discrete vertex, so vertices shared by borders of neighbouring
+ * tiles are sampled once and get the same value. Values are sampled in batches before heights are calculated, which
+ * only read them. Point which isn't cached is sampled on every read, so cache without samples is a plain wrapper of
+ * noise
+ *
+ * Flat tiles use 2d noise at (x, z), tiles of polyhedron use 3d noise
+ */
+class NoiseCache {
+ public:
+  NoiseCache() = default;
+  NoiseCache(Ref<FastNoiseLite> noise, Orientation orientation) : _noise(noise), _orientation(orientation) {}
+
+  /**
+   * @brief Replaces noise and drops all values. Step must be less than half of distance between vertices, so
+   * different vertices never share value
+   */
+  void reset(Ref<FastNoiseLite> noise, Orientation orientation, float step);
+
+  /**
+   * @brief Drops all values and releases their memory
+   */
+  void clear();
+
+  /**
+   * @brief Samples noise at points which aren't cached yet. Distinct points are found first and then sampled by given
+   * number of threads, see parallel_for. Not thread safe
+   */
+  void sample(const std::vector<Vector3Array>& points, int threads_count);
+
+  /**
+   * @brief Value of noise at point or 0 if there is no noise. Cache isn't modified, so several threads may read it
+   */
+  float get(Vector3 point) const;
+
+  int size() const { return _values.size(); }
+
+ private:
+  struct DiscreteVertexHash {
+    size_t operator()(const DiscreteVertex& v) const;
+  };
+
+  Ref<FastNoiseLite> _noise;
+  Orientation _orientation{Orientation::Plane};
+  float _step{1.0};
+  std::unordered_map<DiscreteVertex, float, DiscreteVertexHash> _values;
+
+  DiscreteVertex key(Vector3 point) const;
+  float sample_noise(Vector3 point) const;
+};
+
+}  // namespace sota
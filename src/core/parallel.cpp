@@ -0,0 +1,35 @@
+#include "core/parallel.h"
+
+#include <cstdint>     // for uint32_t, int64_t
+#include <functional>  // for function
+
+#include "tal/worker_thread_pool.h"  // for WorkerThreadPool
+
+namespace sota {
+
+namespace {
+
+void call_body(void* userdata, uint32_t index) {
+  (*static_cast<const std::function<void(int)>*>(userdata))(static_cast<int>(index));
+}
+
+}  // namespace
+
+void parallel_for(int count, int threads_count, const std::function<void(int)>& body) {
+  if (count <= 0) {
+    return;
+  }
+  if (threads_count == 1 || count == 1) {
+    for (int i = 0; i < count; ++i) {
+      body(i);
+    }
+    return;
+  }
+  WorkerThreadPool* pool = WorkerThreadPool::get_singleton();
+  // -1 lets pool use all of its threads
+  int64_t group = pool->add_native_group_task(&call_body, const_cast<std::function<void(int)>*>(&body), count,
+                                              threads_count > 0 ? threads_count : -1, true);
+  pool->wait_for_group_task_completion(group);
+}
+
+}  // namespace sota
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>  // for function
+
+namespace sota {
+
+/**
+ * @brief Calls body for every index in [0, count) on WorkerThreadPool of engine, split into up to threads_count
+ * tasks. Returns when all calls are finished. Indices are handed out one by one, so body must only touch data owned by
+ * its index; results don't depend on number of threads then. Body may edit arrays of meshes, but must not create
+ * engine objects or use scene tree and RenderingServer
+ *
+ * @param threads_count - 0 means all threads of pool, 1 runs body on the calling thread only
+ */
+void parallel_for(int count, int threads_count, const std::function<void(int)>& body);
+
+}  // namespace sota
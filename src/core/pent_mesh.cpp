@@ -22,23 +22,18 @@ PentMesh::PentMesh(Pentagon pentagon, PentagonMeshParams params) : SotaMesh(std:
   set_material(params.material);
   _tesselation_mode = params.tesselation_mode;
   _orientation = params.orientation;
+  _indexed = params.indexed;
+  _attributes = params.attributes;
+  _direct_upload = params.direct_upload;
 }
 
-void PentMesh::init_impl() {
-  calculate_vertices_recursion();
-  recalculate_all_except_vertices();
-}
+void PentMesh::init_impl() { init_from_template(); }
 
-void PentMesh::calculate_vertices_recursion() {
-  vertices_.clear();
-  auto corner_points = _base_ngon->points();
-  auto center = _base_ngon->center();
+void PentMesh::calculate_vertices() { calculate_vertices_recursion(); }
 
-  for (int i = 0; i < 5; ++i) {
-    // for simplicity use "convex" center(e.g. in case of polyhedron)
-    tesselate_into_triangles(corner_points[i], corner_points[(i + 1) % 5], center, _divisions);
-  }
-  return;
+void PentMesh::calculate_vertices_recursion() {
+  // for simplicity use "convex" center(e.g. in case of polyhedron)
+  tesselate_fan(_base_ngon->points(), _base_ngon->center(), _divisions);
 }
 
 void PentMesh::calculate_tex_uv1() {
@@ -73,6 +68,4 @@ void PentMesh::calculate_tex_uv1() {
   }
 }
 
-void PentMesh::update() { request_update(); }
-
 }  // namespace sota
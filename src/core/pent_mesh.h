@@ -19,6 +19,9 @@ struct PentagonMeshParams {
 
   TesselationMode tesselation_mode{TesselationMode::Iterative};
   Orientation orientation{Orientation::Plane};
+  bool indexed{false};
+  int attributes{DEFAULT_MESH_ATTRIBUTES};
+  bool direct_upload{false};
 };
 
 class PentMesh : public SotaMesh {
@@ -32,12 +35,12 @@ class PentMesh : public SotaMesh {
   PentMesh& operator=(PentMesh&& rhs) = delete;
 
   void init_impl() override;
-  void update();
 
   PentMesh(Pentagon pentagon, PentagonMeshParams params);
 
  protected:
   static void _bind_methods() {}
+  void calculate_vertices() override;
 
  private:
   void calculate_tex_uv1() override;
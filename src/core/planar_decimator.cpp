@@ -0,0 +1,165 @@
+#include "core/planar_decimator.h"
+
+#include <algorithm>  // for find, minmax, sort, unique
+#include <array>      // for array
+#include <cmath>      // for abs
+#include <map>        // for map
+#include <set>        // for set
+#include <utility>    // for pair
+#include <vector>     // for vector
+
+#include "tal/arrays.h"   // for Vector3Array, IntArray
+#include "tal/vector3.h"  // for Vector3
+
+namespace sota {
+
+using Triangle = std::array<int, 3>;
+
+DecimationStats PlanarDecimator::decimate(Vector3Array& vertices, IntArray& indices) const {
+  int vertices_count = vertices.size();
+  int triangles_count = indices.size() / 3;
+  DecimationStats stats{.triangles_before = triangles_count, .triangles_after = triangles_count};
+  if (triangles_count == 0) {
+    return stats;
+  }
+
+  const Vector3* positions = vertices.ptr();
+  const int* ids = indices.ptr();
+  std::vector<Triangle> triangles(triangles_count);
+  std::vector<bool> alive(triangles_count, true);
+  std::vector<std::vector<int>> incident(vertices_count);
+  // removed vertices which are covered by triangle, they must stay close to its plane
+  std::vector<std::vector<int>> covered(triangles_count);
+  std::map<std::pair<int, int>, int> edge_uses;
+  for (int t = 0; t < triangles_count; ++t) {
+    triangles[t] = {ids[3 * t], ids[3 * t + 1], ids[3 * t + 2]};
+    for (int j = 0; j < 3; ++j) {
+      incident[triangles[t][j]].push_back(t);
+      ++edge_uses[std::minmax(triangles[t][j], triangles[t][(j + 1) % 3])];
+    }
+  }
+
+  std::vector<bool> fixed(vertices_count, false);
+  std::vector<bool> removed(vertices_count, false);
+  for (const auto& [edge, uses] : edge_uses) {
+    if (uses == 1) {
+      fixed[edge.first] = true;
+      fixed[edge.second] = true;
+    }
+  }
+
+  auto contains = [](const Triangle& t, int v) { return std::find(t.begin(), t.end(), v) != t.end(); };
+  auto normal = [positions](const Triangle& t) {
+    return (positions[t[1]] - positions[t[0]]).cross(positions[t[2]] - positions[t[0]]);
+  };
+  auto ring = [&](int u) {
+    std::vector<int> result;
+    for (int t : incident[u]) {
+      if (alive[t] && contains(triangles[t], u)) {
+        result.push_back(t);
+      }
+    }
+    return result;
+  };
+  auto neighbours = [&](int u) {
+    std::set<int> result;
+    for (int t : ring(u)) {
+      result.insert(triangles[t].begin(), triangles[t].end());
+    }
+    result.erase(u);
+    return result;
+  };
+
+  // half-edge collapse of u into v
+  auto try_collapse = [&](int u, int v, const std::vector<int>& u_ring, const std::set<int>& u_neighbours) {
+    // edge must be shared by exactly 2 triangles, otherwise topology of mesh changes
+    int common = 0;
+    for (int w : neighbours(v)) {
+      common += u_neighbours.contains(w);
+    }
+    if (common != 2) {
+      return false;
+    }
+
+    std::vector<int> points{u};
+    for (int t : u_ring) {
+      points.insert(points.end(), covered[t].begin(), covered[t].end());
+    }
+    // neighbour triangles cover the same vertices
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    for (int t : u_ring) {
+      if (contains(triangles[t], v)) {
+        continue;
+      }
+      Triangle collapsed = triangles[t];
+      *std::find(collapsed.begin(), collapsed.end(), u) = v;
+      Vector3 old_normal = normal(triangles[t]);
+      Vector3 new_normal = normal(collapsed);
+      if (new_normal.length_squared() == 0 || new_normal.dot(old_normal) <= 0) {
+        // degenerated or flipped
+        return false;
+      }
+      new_normal = new_normal.normalized();
+      Vector3 origin = positions[collapsed[0]];
+      for (int p : points) {
+        if (std::abs(new_normal.dot(positions[p] - origin)) > _tolerance) {
+          return false;
+        }
+      }
+    }
+
+    for (int t : u_ring) {
+      if (contains(triangles[t], v)) {
+        alive[t] = false;
+        --stats.triangles_after;
+        continue;
+      }
+      *std::find(triangles[t].begin(), triangles[t].end(), u) = v;
+      incident[v].push_back(t);
+      covered[t] = points;
+    }
+    removed[u] = true;
+    return true;
+  };
+
+  bool collapsed = true;
+  while (collapsed) {
+    collapsed = false;
+    for (int u = 0; u < vertices_count; ++u) {
+      if (fixed[u] || removed[u]) {
+        continue;
+      }
+      std::vector<int> u_ring = ring(u);
+      std::set<int> u_neighbours = neighbours(u);
+      for (int v : u_neighbours) {
+        if (try_collapse(u, v, u_ring, u_neighbours)) {
+          collapsed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  // drop unused vertices
+  std::vector<int> remap(vertices_count, -1);
+  Vector3Array result_vertices;
+  IntArray result_indices;
+  for (int t = 0; t < triangles_count; ++t) {
+    if (!alive[t]) {
+      continue;
+    }
+    for (int v : triangles[t]) {
+      if (remap[v] < 0) {
+        remap[v] = result_vertices.size();
+        result_vertices.push_back(positions[v]);
+      }
+      result_indices.push_back(remap[v]);
+    }
+  }
+  vertices = result_vertices;
+  indices = result_indices;
+  return stats;
+}
+
+}  // namespace sota
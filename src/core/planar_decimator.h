@@ -0,0 +1,37 @@
+#pragma once
+
+#include "tal/arrays.h"  // for Vector3Array, IntArray
+
+namespace sota {
+
+struct DecimationStats {
+  int triangles_before{0};
+  int triangles_after{0};
+
+  DecimationStats& operator+=(const DecimationStats& other) {
+    triangles_before += other.triangles_before;
+    triangles_after += other.triangles_after;
+    return *this;
+  }
+};
+
+/**
+ * @brief Merges nearly coplanar triangles of indexed mesh by collapsing inner vertices into their neighbours
+ *
+ * Vertices of border of mesh (edges used by one triangle) are never moved or removed, so seams between tiles stay
+ * watertight. Every removed vertex stays within tolerance of planes of triangles replacing it
+ */
+class PlanarDecimator {
+ public:
+  PlanarDecimator(float tolerance) : _tolerance(tolerance) {}
+
+  /**
+   * @brief Decimates mesh in place. Unused vertices are dropped and indices are remapped
+   */
+  DecimationStats decimate(Vector3Array& vertices, IntArray& indices) const;
+
+ private:
+  float _tolerance;
+};
+
+}  // namespace sota
@@ -8,13 +8,6 @@ void SmoothShadesProcessor::calculate_normals(bool smooth_normals) {
   } else {
     calculate_flat_normals();
   }
-  meshes_update();
-}
-
-void SmoothShadesProcessor::meshes_update() {
-  for (TileMesh* mesh : _meshes) {
-    mesh->inner_mesh()->update();
-  }
 }
 
 void SmoothShadesProcessor::calculate_flat_normals() {
@@ -25,11 +18,13 @@ void SmoothShadesProcessor::calculate_flat_normals() {
 
 void SmoothShadesProcessor::calculate_smooth_normals() {
   std::vector<DiscreteVertexToNormals> vertex_groups;
+  std::vector<Vector3Array*> normals;
   for (TileMesh* mesh : _meshes) {
     vertex_groups.push_back(mesh->get_discrete_vertex_to_normals());
+    normals.push_back(&mesh->inner_mesh()->get_normals());
   }
 
-  GeneralUtility::make_smooth_normals(vertex_groups);
+  GeneralUtility::make_smooth_normals(vertex_groups, normals);
 }
 
 }  // namespace sota
@@ -13,12 +13,14 @@ class SmoothShadesProcessor {
  public:
   SmoothShadesProcessor(std::vector<TileMesh*> meshes) : _meshes(meshes) {}
 
+  /**
+   * @brief Meshes aren't uploaded, so it may run on background thread. Owner of meshes uploads them afterwards
+   */
   void calculate_normals(bool smooth_normals);
 
  private:
   std::vector<TileMesh*> _meshes;
 
-  void meshes_update();
   void calculate_flat_normals();
   void calculate_smooth_normals();
 };
@@ -0,0 +1,90 @@
+#include "core/surface_regions.h"
+
+#include <algorithm>  // for clamp
+#include <cstdint>    // for uint16_t, uint8_t
+#include <cstring>    // for memcpy
+
+#include "tal/arrays.h"            // for ByteArray
+#include "tal/rendering_server.h"  // for RenderingServer, RID
+#include "tal/vector2.h"           // for Vector2
+#include "tal/vector3.h"           // for Vector3
+
+namespace sota {
+
+SurfaceRegions::SurfaceRegions(RID mesh, int64_t format, int vertices_count, int surface)
+    : _mesh(mesh), _format(format), _vertices_count(vertices_count), _surface(surface) {}
+
+void SurfaceRegions::update_vertices(int first, int count, const Vector3* positions, const Vector3* normals) const {
+  RenderingServer* rs = RenderingServer::get_singleton();
+  int n = _vertices_count;
+  uint32_t vertex_stride = rs->mesh_surface_get_format_vertex_stride(_format, n);
+  uint32_t vertex_offset = rs->mesh_surface_get_format_offset(_format, n, RenderingServer::ARRAY_VERTEX);
+  bool has_normals = _format & RenderingServer::ARRAY_FORMAT_NORMAL;
+  uint32_t normal_stride = has_normals ? rs->mesh_surface_get_format_normal_tangent_stride(_format, n) : 0;
+  uint32_t normal_offset = has_normals ? rs->mesh_surface_get_format_offset(_format, n, RenderingServer::ARRAY_NORMAL)
+                                       : 0;
+  // whole surface is sent at once, otherwise positions and normals are separate regions
+  bool whole = first == 0 && count == n;
+
+  ByteArray vertex_data;
+  vertex_data.resize(count * vertex_stride + (whole ? n * normal_stride : 0));
+  uint8_t* w = vertex_data.ptrw();
+  for (int i = 0; i < count; ++i) {
+    float position[3] = {static_cast<float>(positions[i].x), static_cast<float>(positions[i].y),
+                         static_cast<float>(positions[i].z)};
+    std::memcpy(w + vertex_offset + i * vertex_stride, position, sizeof(position));
+  }
+
+  ByteArray normal_data;
+  if (has_normals && !whole) {
+    normal_data.resize(count * normal_stride);
+  }
+  if (has_normals) {
+    uint8_t* nw = whole ? w + normal_offset : normal_data.ptrw();
+    for (int i = 0; i < count; ++i) {
+      // same encoding as used by RenderingServer for uncompressed normals
+      Vector2 encoded = normals[i].octahedron_encode();
+      uint16_t normal[2] = {static_cast<uint16_t>(std::clamp<float>(encoded.x * 65535, 0, 65535)),
+                            static_cast<uint16_t>(std::clamp<float>(encoded.y * 65535, 0, 65535))};
+      std::memcpy(nw + i * normal_stride, normal, sizeof(normal));
+    }
+  }
+
+  rs->mesh_surface_update_vertex_region(_mesh, _surface, first * vertex_stride, vertex_data);
+  if (has_normals && !whole) {
+    rs->mesh_surface_update_vertex_region(_mesh, _surface, normal_offset + first * normal_stride, normal_data);
+  }
+}
+
+void SurfaceRegions::update_attributes(int first, int count, const Vector2* uv, const Vector2* uv2,
+                                       const float* custom0) const {
+  RenderingServer* rs = RenderingServer::get_singleton();
+  int n = _vertices_count;
+  uint32_t attribute_stride = rs->mesh_surface_get_format_attribute_stride(_format, n);
+  ByteArray attribute_data;
+  attribute_data.resize(count * attribute_stride);
+  uint8_t* a = attribute_data.ptrw();
+
+  auto write_uv = [rs, this, n, count, attribute_stride, a](int array_index, const Vector2* src) {
+    uint32_t offset = rs->mesh_surface_get_format_offset(_format, n, array_index);
+    for (int i = 0; i < count; ++i) {
+      float value[2] = {static_cast<float>(src[i].x), static_cast<float>(src[i].y)};
+      std::memcpy(a + offset + i * attribute_stride, value, sizeof(value));
+    }
+  };
+  if (uv) {
+    write_uv(RenderingServer::ARRAY_TEX_UV, uv);
+  }
+  if (uv2) {
+    write_uv(RenderingServer::ARRAY_TEX_UV2, uv2);
+  }
+  if (custom0) {
+    uint32_t offset = rs->mesh_surface_get_format_offset(_format, n, RenderingServer::ARRAY_CUSTOM0);
+    for (int i = 0; i < count; ++i) {
+      std::memcpy(a + offset + i * attribute_stride, custom0 + i, sizeof(float));
+    }
+  }
+  rs->mesh_surface_update_attribute_region(_mesh, _surface, first * attribute_stride, attribute_data);
+}
+
+}  // namespace sota
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>  // for int64_t, uint32_t
+
+#include "tal/rendering_server.h"  // for RID
+#include "tal/vector2.h"           // for Vector2
+#include "tal/vector3.h"           // for Vector3
+
+namespace sota {
+
+/**
+ * @brief Writes vertex data straight into buffers of surface of RenderingServer mesh, bypassing rebuild of surface.
+ * Positions of all vertices are followed by interleaved normals in vertex buffer, other attributes are interleaved in
+ * attribute buffer. Tangents are not supported
+ */
+class SurfaceRegions {
+ public:
+  /**
+   * @param format - format of surface including custom formats bits
+   * @param vertices_count - number of vertices of whole surface
+   * @param surface - index of surface in mesh
+   */
+  SurfaceRegions(RID mesh, int64_t format, int vertices_count, int surface = 0);
+
+  /**
+   * @brief Updates positions and, if surface has them, normals of vertices [first, first + count)
+   */
+  void update_vertices(int first, int count, const Vector3* positions, const Vector3* normals) const;
+
+  /**
+   * @brief Updates attributes of vertices [first, first + count). Only UVs and single float custom0 are supported and
+   * every attribute of surface has to be passed, since the rest of region is zeroed
+   */
+  void update_attributes(int first, int count, const Vector2* uv, const Vector2* uv2, const float* custom0) const;
+
+ private:
+  RID _mesh;
+  int64_t _format;
+  int _vertices_count;
+  int _surface;
+};
+
+}  // namespace sota
@@ -0,0 +1,49 @@
+#include "core/tesselation_cache.h"
+
+#include <map>     // for erase_if
+#include <memory>  // for make_shared
+#include <mutex>   // for lock_guard
+
+namespace sota {
+
+TesselationCache& TesselationCache::instance() {
+  static TesselationCache cache;
+  return cache;
+}
+
+std::shared_ptr<const Tesselation> TesselationCache::get(const TesselationKey& key,
+                                                         const std::function<Tesselation()>& make_tesselation) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (auto it = _tesselations.find(key); it != _tesselations.end()) {
+      if (auto tesselation = it->second.lock()) {
+        return tesselation;
+      }
+    }
+  }
+
+  auto tesselation = std::make_shared<const Tesselation>(make_tesselation());
+  std::lock_guard<std::mutex> lock(_mutex);
+  // templates are inserted rarely, so unused ones are swept here
+  std::erase_if(_tesselations, [](const auto& entry) { return entry.second.expired(); });
+  auto [it, inserted] = _tesselations.try_emplace(key, tesselation);
+  if (!inserted) {
+    if (auto stored = it->second.lock()) {
+      return stored;
+    }
+    it->second = tesselation;
+  }
+  return tesselation;
+}
+
+void TesselationCache::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _tesselations.clear();
+}
+
+int TesselationCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _tesselations.size();
+}
+
+}  // namespace sota
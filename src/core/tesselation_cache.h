@@ -0,0 +1,74 @@
+#pragma once
+
+#include <compare>     // for operator<=>
+#include <functional>  // for function
+#include <map>         // for map
+#include <memory>      // for shared_ptr, weak_ptr
+#include <mutex>       // for mutex
+
+#include "tal/arrays.h"  // for Vector3Array, Vector2Array, IntArray
+
+namespace sota {
+
+/**
+ * @brief Parameters which fully define tesselation of flat tile up to translation
+ */
+struct TesselationKey {
+  int sides{0};
+  int divisions{0};
+  int tesselation_mode{0};
+  bool indexed{false};
+  int attributes{0};
+  // circumradius of base polygon measured in EPSILON steps
+  int radius_steps{0};
+  int clip_mask{0};
+  bool frame_state{false};
+  float frame_offset{0.0};
+
+  auto operator<=>(const TesselationKey&) const = default;
+};
+
+/**
+ * @brief Tesselation of tile with center of base polygon at origin
+ */
+struct Tesselation {
+  Vector3Array vertices;
+  IntArray indices;
+  Vector3Array normals;
+  Vector2Array tex_uv1;
+};
+
+/**
+ * @brief Process-wide storage of tesselations. Tiles with identical parameters share one template and only translate
+ * it to their position. Meshes own templates they are built from, cache only refers to them, so template is dropped
+ * once the last mesh using it is destroyed or tesselated differently
+ */
+class TesselationCache {
+ public:
+  static TesselationCache& instance();
+
+  /**
+   * @brief Returns template for key. Calls make_tesselation only if there is no template yet. Template is made without
+   * lock, so tiles with different keys are tesselated in parallel. If several threads make template of the same key,
+   * the first stored one is shared
+   */
+  std::shared_ptr<const Tesselation> get(const TesselationKey& key,
+                                         const std::function<Tesselation()>& make_tesselation);
+
+  /**
+   * @brief Forgets all templates. Meshes keep templates they use, so it's safe to call at any time
+   */
+  void clear();
+  /**
+   * @brief Number of stored templates, including ones not used anymore but not swept yet
+   */
+  int size() const;
+
+ private:
+  TesselationCache() = default;
+
+  mutable std::mutex _mutex;
+  std::map<TesselationKey, std::weak_ptr<const Tesselation>> _tesselations;
+};
+
+}  // namespace sota
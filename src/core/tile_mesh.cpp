@@ -3,8 +3,11 @@
 namespace sota {
 
 DiscreteVertexToNormals TileMesh::get_discrete_vertex_to_normals() {
+  if (!inner_mesh()->has_attribute(MeshAttribute::Normal)) {
+    return {};
+  }
   auto d = VertexToNormalDiscretizer(0.0001);
-  d.discretize(inner_mesh()->get_vertices(), inner_mesh()->get_normals());
+  d.discretize(inner_mesh()->get_vertices());
   return d.get();
 }
 
@@ -0,0 +1,73 @@
+#include "core/tile_picker.h"
+
+#include <cmath>     // for sqrt
+#include <optional>  // for optional, nullopt
+
+#include "core/tile_mesh.h"  // for TileMesh
+#include "tal/camera.h"      // for Camera3D, Viewport
+#include "tal/event.h"       // for InputEvent, InputEventMouse
+#include "tal/reference.h"   // for Ref
+#include "tal/vector2.h"     // for Vector2
+#include "tal/vector3.h"     // for Vector3
+
+namespace sota {
+
+void TilePicker::handle_input(Viewport* viewport, const Ref<InputEvent>& event, const PickFunction& pick) {
+  auto* mouse_event = dynamic_cast<InputEventMouse*>(event.ptr());
+  Camera3D* camera = viewport ? viewport->get_camera_3d() : nullptr;
+  if (!mouse_event || !camera) {
+    return;
+  }
+  Vector2 position = mouse_event->get_position();
+  std::optional<TilePick> hit = pick(camera->project_ray_origin(position), camera->project_ray_normal(position));
+  TilePick picked = hit.value_or(TilePick{});
+
+  if (picked.mesh != _hovered.ptr()) {
+    if (_hovered.ptr() && _hovered->has_method("handle_mouse_exited")) {
+      _hovered->call("handle_mouse_exited");
+    }
+    _hovered = Ref<TileMesh>(picked.mesh);
+    if (_hovered.ptr() && _hovered->has_method("handle_mouse_entered")) {
+      _hovered->call("handle_mouse_entered");
+    }
+  }
+  if (picked.mesh && picked.mesh->has_method("handle_input_event")) {
+    // shape index is always 0, the same as for single collision shape of tile
+    picked.mesh->call("handle_input_event", camera, event, picked.position, picked.normal, 0, picked.instance);
+  }
+}
+
+void TilePicker::reset() { _hovered = Ref<TileMesh>(); }
+
+std::optional<float> TilePicker::intersect_plane(Vector3 origin, Vector3 direction) {
+  if (direction.y == 0) {
+    return std::nullopt;
+  }
+  float t = -origin.y / direction.y;
+  if (t < 0) {
+    return std::nullopt;
+  }
+  return t;
+}
+
+std::optional<float> TilePicker::intersect_sphere(Vector3 origin, Vector3 direction, float radius) {
+  float a = direction.dot(direction);
+  float b = 2 * origin.dot(direction);
+  float c = origin.dot(origin) - radius * radius;
+  float discriminant = b * b - 4 * a * c;
+  if (a == 0 || discriminant < 0) {
+    return std::nullopt;
+  }
+  float root = std::sqrt(discriminant);
+  float t = (-b - root) / (2 * a);
+  if (t < 0) {
+    // origin is inside of sphere
+    t = (-b + root) / (2 * a);
+  }
+  if (t < 0) {
+    return std::nullopt;
+  }
+  return t;
+}
+
+}  // namespace sota
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>  // for function
+#include <optional>    // for optional
+
+#include "core/tile_mesh.h"  // for TileMesh
+#include "tal/camera.h"      // for Camera3D, Viewport
+#include "tal/event.h"       // for InputEvent
+#include "tal/mesh.h"        // for MeshInstance3D
+#include "tal/reference.h"   // for Ref
+#include "tal/vector3.h"     // for Vector3
+
+namespace sota {
+
+/**
+ * @brief Tile hit by ray. Position and normal are in global space
+ */
+struct TilePick {
+  TileMesh* mesh{nullptr};
+  // null if tile is drawn by chunk
+  MeshInstance3D* instance{nullptr};
+  Vector3 position;
+  Vector3 normal;
+};
+
+/**
+ * @brief Delivers mouse events to tiles without physics bodies. Tile under mouse is found analytically by owner of
+ * tiles, handlers of tile mesh are the same as connected to signals of StaticBody3D: handle_mouse_entered,
+ * handle_mouse_exited and handle_input_event
+ */
+class TilePicker {
+ public:
+  using PickFunction = std::function<std::optional<TilePick>(Vector3 origin, Vector3 direction)>;
+
+  /**
+   * @brief Casts ray of current camera under mouse and dispatches event to picked tile. Non-mouse events are ignored
+   */
+  void handle_input(Viewport* viewport, const Ref<InputEvent>& event, const PickFunction& pick);
+
+  /**
+   * @brief Forgets hovered tile, e.g. when tiles are rebuilt
+   */
+  void reset();
+
+  /**
+   * @brief Distance along ray to plane y = 0
+   */
+  static std::optional<float> intersect_plane(Vector3 origin, Vector3 direction);
+
+  /**
+   * @brief Distance along ray to the nearest intersection with sphere centered at origin of coordinates
+   */
+  static std::optional<float> intersect_sphere(Vector3 origin, Vector3 direction, float radius);
+
+ private:
+  Ref<TileMesh> _hovered;
+};
+
+}  // namespace sota
@@ -2,7 +2,8 @@
 
 #include <cmath>  // for abs
 
-#include <cmath>  // for sqrt, cos, sin
+#include <cmath>   // for sqrt, cos, sin
+#include <vector>  // for vector
 
 #include "algo/constants.h"  // for PI
 #include "tal/arrays.h"      // for Array, Vector3Array
@@ -19,6 +20,18 @@ float small_radius(float diameter) { return radius(diameter) * std::sqrt(3) / 2;
 float pointy_top_x_offset(float diameter) { return small_radius(diameter) * 2; }
 float pointy_top_y_offset(float diameter) { return diameter * 3.0f / 4.0f; }
 
+std::vector<int> lod_divisions(int divisions, int levels) {
+  std::vector<int> result{divisions};
+  while (static_cast<int>(result.size()) < levels && result.back() > 1) {
+    int next = result.back() / 2;
+    while (divisions % next != 0) {
+      --next;
+    }
+    result.push_back(next);
+  }
+  return result;
+}
+
 bool epsilonEqual(float lhs, float rhs) { return std::abs(lhs - rhs) < EPSILON; }
 bool epsilonEqual(float lhs, float rhs, float tol) { return std::abs(lhs - rhs) < tol; }
 bool epsilonNotEqual(float lhs, float rhs) { return !epsilonEqual(lhs, rhs); }
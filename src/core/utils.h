@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>  // for vector
+
 #include "tal/arrays.h"   // for Array, Vector3Array
 #include "tal/vector2.h"  // for Vector2
 #include "tal/vector3.h"  // for Vector3
@@ -14,6 +16,12 @@ float small_radius(float diameter);
 float pointy_top_x_offset(float diameter);
 float pointy_top_y_offset(float diameter);
 
+/**
+ * @brief Divisions of levels of detail starting from given one. Every next level has at most half of divisions of
+ * previous one and divides initial divisions, so its lattice is a subset of lattice of the first level
+ */
+std::vector<int> lod_divisions(int divisions, int levels);
+
 template <typename T>
 bool is_odd(T t) {
   return t & 1;
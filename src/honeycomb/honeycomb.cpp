@@ -3,18 +3,19 @@
 #include <algorithm>      // for sort, max, min
 #include <cmath>          // for pow
 #include <limits>         // for numeric_limits
-#include <memory>         // for allocator_traits<>:...
+#include <memory>         // for make_unique
 #include <random>         // for mt19937, uniform_in...
 #include <unordered_map>  // for unordered_map, unor...
 #include <utility>        // for pair
 #include <vector>         // for vector
 
 #include "core/general_utility.h"      // for GeneralUtility
-#include "core/godot_utils.h"          // for clean_children
+#include "core/godot_utils.h"          // for reconnect_changed
 #include "core/hex_grid.h"             // for TilesLayout
 #include "core/hex_mesh.h"             // for HexMesh, HexMeshParams
 #include "core/hexagonal_utility.h"    // for HexagonalUtility
-#include "core/mesh.h"                 // for SotaMesh
+#include "core/mesh.h"                 // for SotaMesh, Orientation
+#include "core/noise_cache.h"          // for NoiseCache
 #include "core/rectangular_utility.h"  // for RectangularUtility
 #include "core/smooth_shades_processor.h"
 #include "core/tile_mesh.h"             // for TileMesh
@@ -39,6 +40,11 @@
 
 namespace sota {
 
+// variants of shared materials, see MaterialCache
+constexpr int CELL_MATERIAL = 0;
+constexpr int HONEY_MATERIAL = 1;
+constexpr int SELECTION_MATERIAL = 2;
+
 void Honeycomb::_bind_methods() {
   ClassDB::bind_method(D_METHOD("get_smooth_normals"), &Honeycomb::get_smooth_normals);
   ClassDB::bind_method(D_METHOD("set_smooth_normals", "p_smooth_normals"), &Honeycomb::set_smooth_normals);
@@ -102,14 +108,23 @@ void Honeycomb::_bind_methods() {
   ClassDB::bind_method(D_METHOD("all_cells_empty"), &Honeycomb::all_cells_empty);
 }
 
-void Honeycomb::init() {
+void Honeycomb::generate() {
   init_col_row_layout();
   if (_col_row_layout.empty()) {
     return;
   }
   init_hexmesh();
+  index_tiles();
+  report_progress(0.3);
+  if (is_cancelled()) {
+    return;
+  }
 
   calculate_cells();
+  report_progress(0.6);
+  if (is_cancelled()) {
+    return;
+  }
 
   prepare_heights_calculation();
   calculate_final_heights();
@@ -117,67 +132,134 @@ void Honeycomb::init() {
   calculate_normals();
 }
 
+void Honeycomb::init_materials() {
+  _materials.clear();
+  _materials.get(_shader, CELL_MATERIAL, [this](Ref<ShaderMaterial> material) {
+    if (_cell_texture.ptr()) {
+      material->set_shader_parameter("cell_texture", _cell_texture.ptr());
+    }
+    // selected cells are marked by instance uniform "selected"
+    if (_selection_texture.ptr()) {
+      material->set_shader_parameter("selection_texture", _selection_texture.ptr());
+    }
+  });
+  if (_selection_shader.ptr()) {
+    _materials.get(_selection_shader, SELECTION_MATERIAL, [this](Ref<ShaderMaterial> material) {
+      if (_selection_texture.ptr()) {
+        material->set_shader_parameter("cell_texture", _selection_texture.ptr());
+      }
+    });
+  }
+  _materials.get(_honey_shader, HONEY_MATERIAL, [this](Ref<ShaderMaterial> material) {
+    if (_honey_texture.ptr()) {
+      material->set_shader_parameter("honey_texture", _honey_texture.ptr());
+    }
+  });
+}
+
+void Honeycomb::init_chunks() {
+  HexGrid::init_chunks();
+  add_chunks([](Tile* tile) { return static_cast<HoneycombTile*>(tile)->honey_mesh()->inner_mesh(); });
+}
+
 void Honeycomb::set_smooth_normals(const bool p_smooth_normals) {
+  if (queue_if_generating("set_smooth_normals", p_smooth_normals)) {
+    return;
+  }
   _smooth_normals = p_smooth_normals;
   calculate_normals();
+  publish();
 }
 
 void Honeycomb::set_honey_random_level(const bool p_honey_random_level) {
+  if (queue_if_generating("set_honey_random_level", p_honey_random_level)) {
+    return;
+  }
   _honey_random_level = p_honey_random_level;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_honey_min_offset(float p_honey_min_offset) {
+  if (queue_if_generating("set_honey_min_offset", p_honey_min_offset)) {
+    return;
+  }
   _honey_min_offset = p_honey_min_offset;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_honey_max_gain(float p_honey_max_gain) {
+  if (queue_if_generating("set_honey_max_gain", p_honey_max_gain)) {
+    return;
+  }
   _honey_max_gain = p_honey_max_gain;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_honey_fill_steps(int p_honey_fill_steps) {
+  if (queue_if_generating("set_honey_fill_steps", p_honey_fill_steps)) {
+    return;
+  }
   _honey_fill_steps = p_honey_fill_steps;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_noise(const Ref<FastNoiseLite> p_noise) {
+  if (queue_if_generating("set_noise", p_noise)) {
+    return;
+  }
+  reconnect_changed(_noise.ptr(), p_noise.ptr(), Callable(this, "request_init"));
   _noise = p_noise;
   if (_noise.ptr()) {
-    _noise->connect("changed", Callable(this, "init"));
-    init();
+    request_init();
   }
 }
 
 void Honeycomb::set_cell_texture(const Ref<Texture> p_cell_texture) {
+  if (queue_if_generating("set_cell_texture", p_cell_texture)) {
+    return;
+  }
   _cell_texture = p_cell_texture;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_honey_texture(const Ref<Texture> p_honey_texture) {
+  if (queue_if_generating("set_honey_texture", p_honey_texture)) {
+    return;
+  }
   _honey_texture = p_honey_texture;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_selection_texture(const Ref<Texture> p_selection_texture) {
+  if (queue_if_generating("set_selection_texture", p_selection_texture)) {
+    return;
+  }
   _selection_texture = p_selection_texture;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_bottom_offset(float p_bottom_offset) {
+  if (queue_if_generating("set_bottom_offset", p_bottom_offset)) {
+    return;
+  }
   _bottom_offset = p_bottom_offset;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_honey_shader(const Ref<Shader> p_honey_shader) {
+  if (queue_if_generating("set_honey_shader", p_honey_shader)) {
+    return;
+  }
   _honey_shader = p_honey_shader;
-  init();
+  request_init();
 }
 
 void Honeycomb::set_selection_shader(const Ref<Shader> p_selection_shader) {
+  if (queue_if_generating("set_selection_shader", p_selection_shader)) {
+    return;
+  }
   _selection_shader = p_selection_shader;
-  init();
+  request_init();
 }
 
 bool Honeycomb::get_smooth_normals() const { return _smooth_normals; }
@@ -216,6 +298,10 @@ float Honeycomb::generate_random_honey_y_offset() { return generate_offset(gener
 float Honeycomb::generate_min_honey_y_offset() { return generate_offset(generate_min_honey_step()); }
 
 Array Honeycomb::get_cells_by_order(SortingOrder order, std::function<bool(HoneycombHoney*)> pred) const {
+  if (is_generating()) {
+    // cells are being rebuilt
+    return Array();
+  }
   std::vector<std::pair<int, HoneycombHoney*>> all_cells;
   for (auto& row : _tiles_layout) {
     for (auto& tile_ptr : row) {
@@ -240,6 +326,9 @@ Array Honeycomb::get_cells_by_order(SortingOrder order, std::function<bool(Honey
 
 Array Honeycomb::get_cells() const {
   Array res;
+  if (is_generating()) {
+    return res;
+  }
   for (auto& row : _tiles_layout) {
     for (auto& tile_ptr : row) {
       HoneycombTile* tile = dynamic_cast<HoneycombTile*>(tile_ptr);
@@ -265,6 +354,10 @@ Array Honeycomb::get_max_cells() const {
 }
 
 bool Honeycomb::all_cells_empty() const {
+  if (is_generating()) {
+    // honey of new cells isn't filled yet
+    return true;
+  }
   for (auto& row : _tiles_layout) {
     for (auto& tile_ptr : row) {
       HoneycombTile* tile = dynamic_cast<HoneycombTile*>(tile_ptr);
@@ -293,31 +386,17 @@ void Honeycomb::init_hexmesh() {
     }
   }
 
-  _tiles_layout.clear();
-  clean_children(*this);
+  retire_tiles();
+  _picker.reset();
+  Ref<ShaderMaterial> cell_material = _materials.find(_shader, CELL_MATERIAL);
+  Ref<ShaderMaterial> selection_material = _materials.find(_selection_shader, SELECTION_MATERIAL);
+  Ref<ShaderMaterial> honey_material = _materials.find(_honey_shader, HONEY_MATERIAL);
 
   for (auto row : _col_row_layout) {
     _tiles_layout.push_back({});
     for (auto val : row) {
       int id = calculate_id(val.x, val.z);
 
-      Ref<ShaderMaterial> cell_material;
-      cell_material.instantiate();
-      if (_shader.ptr()) {
-        cell_material->set_shader(_shader);
-      }
-      if (_cell_texture.ptr()) {
-        cell_material->set_shader_parameter("cell_texture", _cell_texture.ptr());
-      }
-
-      Ref<ShaderMaterial> cell_selection_material;
-      cell_selection_material.instantiate();
-      if (_selection_shader.ptr()) {
-        cell_selection_material->set_shader(_selection_shader);
-      }
-      if (_selection_texture.ptr()) {
-        cell_selection_material->set_shader_parameter("cell_texture", _selection_texture.ptr());
-      }
       Hexagon cell_hex = make_hexagon_at_position(cells_offsets[id], _diameter);
       HoneycombCellMeshParams cell_params{.hex_mesh_params = HexMeshParams{.id = id,
                                                                            .diameter = _diameter,
@@ -325,18 +404,12 @@ void Honeycomb::init_hexmesh() {
                                                                            .frame_offset = _frame_offset,
                                                                            .material = cell_material,
                                                                            .divisions = _divisions,
-                                                                           .clip_options = ClipOptions{}},
+                                                                           .clip_options = ClipOptions{},
+                                                                           .indexed = _indexed,
+                                                                           .attributes = _mesh_attributes,
+                                                                           .direct_upload = _direct_upload},
                                           .noise = _noise,
-                                          .selection_material = cell_selection_material};
-
-      Ref<ShaderMaterial> honey_material;
-      honey_material.instantiate();
-      if (_honey_shader.ptr()) {
-        honey_material->set_shader(_honey_shader);
-      }
-      if (_honey_texture.ptr()) {
-        honey_material->set_shader_parameter("honey_texture", _honey_texture.ptr());
-      }
+                                          .selection_material = selection_material};
 
       int honey_level = _honey_random_level ? generate_random_honey_step() : generate_min_honey_step();
       Vector2 xz = honey_offsets[id + calculate_honey_id_offset()];
@@ -350,17 +423,18 @@ void Honeycomb::init_hexmesh() {
                                                                              .frame_offset = 0.0,
                                                                              .material = honey_material,
                                                                              .divisions = _divisions,
-                                                                             .clip_options = ClipOptions{}},
-                                            .noise = _noise,
+                                                                             .clip_options = ClipOptions{},
+                                                                             .indexed = _indexed,
+                                                                             .attributes = _mesh_attributes,
+                                                                             .direct_upload = _direct_upload},
                                             .max_level = _honey_fill_steps,
                                             .fill_delta = get_honey_step_value(),
                                             .min_offset = _honey_min_offset};
 
       Ref<HoneycombCell> cell_tile = Ref<HoneycombCell>(memnew(HoneycombCell(cell_hex, cell_params)));
       Ref<HoneycombHoney> honey_tile = Ref<HoneycombHoney>(memnew(HoneycombHoney(honey_hex, honey_params)));
-      HoneycombTile* t =
-          memnew(HoneycombTile(cell_tile, honey_tile, this, OffsetCoordinates{.row = val.x, .col = val.z}));
-      _tiles_layout.back().push_back(t);
+      OffsetCoordinates offset_coord{.row = val.x, .col = val.z};
+      _tiles_layout.back().push_back(add_tile(std::make_unique<HoneycombTile>(cell_tile, honey_tile, offset_coord)));
     }
   }
 }
@@ -372,7 +446,6 @@ void Honeycomb::calculate_cells() {
 
       cell_mesh->calculate_heights(_bottom_offset);
       cell_mesh->inner_mesh()->calculate_normals();
-      cell_mesh->inner_mesh()->update();
     }
   }
 }
@@ -395,6 +468,17 @@ void Honeycomb::calculate_normals() {
 }
 
 void Honeycomb::prepare_heights_calculation() {
+  // honey meshes of neighbouring tiles share vertices on borders, so noise is sampled once per distinct vertex
+  std::vector<Vector3Array> vertices;
+  for (auto& row : _tiles_layout) {
+    for (auto& tile_ptr : row) {
+      vertices.push_back(dynamic_cast<HoneycombTile*>(tile_ptr)->honey_mesh()->inner_mesh()->get_vertices());
+    }
+  }
+  NoiseCache noise;
+  noise.reset(_noise, Orientation::Plane, _diameter / (_divisions * 2) / 4);
+  noise.sample(vertices, 0);
+
   float global_min_y = std::numeric_limits<float>::max();
   float global_max_y = std::numeric_limits<float>::min();
   for (auto& row : _tiles_layout) {
@@ -402,7 +486,7 @@ void Honeycomb::prepare_heights_calculation() {
       HoneycombTile* tile = dynamic_cast<HoneycombTile*>(tile_ptr);
       HoneycombHoney* honey_mesh = tile->honey_mesh().ptr();
 
-      honey_mesh->calculate_initial_heights();
+      honey_mesh->calculate_initial_heights(noise);
       auto [mesh_min_z, mesh_max_z] = honey_mesh->get_min_max_height();
       global_min_y = std::min(global_min_y, mesh_min_z);
       global_max_y = std::max(global_max_y, mesh_max_z);
@@ -446,13 +530,19 @@ void RectHoneycomb::_bind_methods() {
 }
 
 void RectHoneycomb::set_height(const int p_height) {
+  if (queue_if_generating("set_height", p_height)) {
+    return;
+  }
   _height = p_height > 1 ? p_height : 1;
-  init();
+  request_init();
 }
 
 void RectHoneycomb::set_width(const int p_width) {
+  if (queue_if_generating("set_width", p_width)) {
+    return;
+  }
   _width = p_width > 1 ? p_width : 1;
-  init();
+  request_init();
 }
 
 int RectHoneycomb::get_height() const { return _height; }
@@ -476,6 +566,10 @@ void HexagonalHoneycomb::_bind_methods() {
 }
 
 Vector3 HexagonalHoneycomb::get_center() const {
+  if (is_generating()) {
+    // cells are being rebuilt
+    return Vector3(0, 0, 0);
+  }
   int total = 0;
   for (auto& row : _tiles_layout) {
     total += row.size();
@@ -497,8 +591,11 @@ Vector3 HexagonalHoneycomb::get_center() const {
 }
 
 void HexagonalHoneycomb::set_size(const int p_size) {
+  if (queue_if_generating("set_size", p_size)) {
+    return;
+  }
   _size = p_size > 1 ? p_size : 1;
-  init();
+  request_init();
 }
 
 int HexagonalHoneycomb::get_size() const { return _size; }
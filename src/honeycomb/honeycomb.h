@@ -52,6 +52,11 @@ class Honeycomb : public HexGrid {
   void set_honey_shader(const Ref<Shader> p_honey_shader);
   Ref<Shader> get_honey_shader() const;
 
+  /**
+   * @brief Deprecated property shared with Godot inspector, kept for existing scenes. If set, selected cell is drawn by
+   * material of this shader with selection texture as "cell_texture". Otherwise cell shader marks selected cells by
+   * instance uniform "selected" and takes their texture from "selection_texture"
+   */
   void set_selection_shader(const Ref<Shader> p_selection_shader);
   Ref<Shader> get_selection_shader() const;
 
@@ -63,8 +68,10 @@ class Honeycomb : public HexGrid {
  protected:
   static void _bind_methods();
 
-  void init() override;
+  void init_materials() override;
+  void generate() override;
   void init_hexmesh() override;
+  void init_chunks() override;
 
   virtual int calculate_honey_id_offset() = 0;
 
@@ -72,9 +79,9 @@ class Honeycomb : public HexGrid {
   Ref<Texture> _cell_texture;
   Ref<Texture> _honey_texture;
   Ref<Texture> _selection_texture;
-  Ref<Shader> _selection_shader;
   Ref<FastNoiseLite> _noise;
   Ref<Shader> _honey_shader;
+  Ref<Shader> _selection_shader;
   float _bottom_offset{-0.5};
   bool _smooth_normals{false};
   bool _honey_random_level{false};
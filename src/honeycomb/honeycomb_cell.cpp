@@ -3,10 +3,12 @@
 #include <algorithm>  // for min
 #include <cmath>      // for abs
 #include <limits>     // for numeric_limits
+#include <span>       // for span
 #include <utility>    // for tuple_element<...
 #include <vector>     // for vector
 
 #include "core/general_utility.h"  // for GeneralUtility
+#include "core/godot_utils.h"      // for reconnect_changed
 #include "core/hex_mesh.h"         // for HexMesh
 #include "core/utils.h"            // for cosrp
 #include "misc/discretizer.h"      // for Dicretizer
@@ -19,6 +21,7 @@
 #include "tal/event.h"             // for InputEventMouse
 #include "tal/godot_core.h"        // for D_METHOD, ClassDB
 #include "tal/material.h"          // for ShaderMaterial
+#include "tal/mesh.h"              // for MeshInstance3D
 #include "tal/noise.h"             // for FastNoiseLite
 #include "tal/vector2.h"           // for Vector2
 
@@ -26,7 +29,8 @@ namespace sota {
 
 HoneycombCell::HoneycombCell(Hexagon hex, HoneycombCellMeshParams params)
     : _hex_mesh(Ref<HexMesh>(memnew(HexMesh(hex, params.hex_mesh_params)))) {
-  _hex_mesh->init();
+  // uploaded by owner on the main thread
+  _hex_mesh->build();
   _noise = params.noise;
   _selection_material = params.selection_material;
 }
@@ -38,10 +42,16 @@ void HoneycombCell::_bind_methods() {
 }
 
 void HoneycombCell::handle_input_event(Camera3D* p_camera, const Ref<InputEvent>& p_event,
-                                       const Vector3& p_event_position, const Vector3& p_normal, int32_t p_shape_idx) {
+                                       const Vector3& p_event_position, const Vector3& p_normal, int32_t p_shape_idx,
+                                       MeshInstance3D* p_instance) {
   if (auto* mouse_event = dynamic_cast<InputEventMouse*>(p_event.ptr()); mouse_event) {
-    if (mouse_event->get_button_mask().has_flag(MOUSE_BUTTON_MASK_LEFT) && mouse_event->is_pressed()) {
-      _hex_mesh->set_material(_selection_material);
+    // cells merged into chunk have no instance of their own
+    if (mouse_event->get_button_mask().has_flag(MOUSE_BUTTON_MASK_LEFT) && mouse_event->is_pressed() && p_instance) {
+      if (_selection_material.ptr()) {
+        p_instance->set_material_override(_selection_material);
+      } else {
+        p_instance->set_instance_shader_parameter("selected", true);
+      }
     }
   }
 }
@@ -54,17 +64,13 @@ void HoneycombCell::handle_mouse_exited() {
 }
 
 void HoneycombCell::set_noise(Ref<FastNoiseLite> p_noise) {
+  reconnect_changed(_noise.ptr(), p_noise.ptr(), Callable(this, "request_update"));
   _noise = p_noise;
   if (_noise.ptr()) {
-    _noise->connect("changed", Callable(this, "request_update"));
     _hex_mesh->update();
   }
 }
 
-void HoneycombCell::set_selection_material(Ref<ShaderMaterial> p_selection_material) {
-  _selection_material = p_selection_material;
-}
-
 void HoneycombCell::calculate_heights(float bottom_offset) {
   auto [coeffs, coeffs_precalc] =
       PointToLineDistance_EquationBased::get_border_line_coeffs(_hex_mesh->get_R(), _hex_mesh->get_r(), {});
@@ -73,24 +79,24 @@ void HoneycombCell::calculate_heights(float bottom_offset) {
 
   float distance_to_border;
   unsigned int coeffs_size = coeffs.size();
-  auto vertices = _hex_mesh->get_vertices();
-  for (auto& v : vertices) {
-    distance_to_border = std::numeric_limits<float>::max();
-    for (unsigned int i = 0; i < coeffs_size; ++i) {
-      distance_to_border = std::min(distance_to_border, std::abs(coeffs[i][0] * (v.x - center.x) +
-                                                                 coeffs[i][1] * (v.z - center.z) + coeffs[i][2]) /
-                                                            coeffs_precalc[i]);
+  _hex_mesh->edit_vertices([&](std::span<Vector3> vertices) {
+    for (auto& v : vertices) {
+      distance_to_border = std::numeric_limits<float>::max();
+      for (unsigned int i = 0; i < coeffs_size; ++i) {
+        distance_to_border = std::min(distance_to_border, std::abs(coeffs[i][0] * (v.x - center.x) +
+                                                                   coeffs[i][1] * (v.z - center.z) + coeffs[i][2]) /
+                                                              coeffs_precalc[i]);
+      }
+
+      Vector3 center_point = center + Vector3(0, bottom_offset, 0);
+
+      float distance_to_center = Vector2(center_point.x, center_point.z).distance_to(Vector2(v.x, v.z));
+      float approx_end = center_point.y;
+      auto t = [](float to_border, float to_projection) { return to_border / (to_border + to_projection); };
+
+      v.y = center.y + cosrp(v.y, approx_end, t(distance_to_border, distance_to_center));
     }
-
-    Vector3 center_point = center + Vector3(0, bottom_offset, 0);
-
-    float distance_to_center = Vector2(center_point.x, center_point.z).distance_to(Vector2(v.x, v.z));
-    float approx_end = center_point.y;
-    auto t = [](float to_border, float to_projection) { return to_border / (to_border + to_projection); };
-
-    v.y = center.y + cosrp(v.y, approx_end, t(distance_to_border, distance_to_center));
-  }
-  _hex_mesh->set_vertices(vertices);
+  });
 }
 
 }  // namespace sota
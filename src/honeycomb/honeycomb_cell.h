@@ -8,6 +8,7 @@
 #include "tal/camera.h"      // for Camera3D
 #include "tal/event.h"       // for InputEvent
 #include "tal/material.h"    // for ShaderMaterial
+#include "tal/mesh.h"        // for MeshInstance3D
 #include "tal/noise.h"       // for FastNoiseLite
 #include "tal/reference.h"   // for Ref
 #include "tal/vector3.h"     // for Vector3
@@ -18,6 +19,7 @@ class Hexagon;
 struct HoneycombCellMeshParams {
   HexMeshParams hex_mesh_params;
   Ref<FastNoiseLite> noise{nullptr};
+  // deprecated, see Honeycomb::set_selection_shader()
   Ref<ShaderMaterial> selection_material{nullptr};
 };
 
@@ -36,7 +38,6 @@ class HoneycombCell : public TileMesh {
 
   // setters
   void set_noise(Ref<FastNoiseLite> noise);
-  void set_selection_material(Ref<ShaderMaterial> p_selection_material);
 
   void calculate_heights(float bottom_offset);
   HexMesh* inner_mesh() const override { return _hex_mesh.ptr(); }
@@ -53,8 +54,14 @@ class HoneycombCell : public TileMesh {
 
   void handle_mouse_entered();
   void handle_mouse_exited();
+  /**
+   * @brief Selection is shown by instance uniform "selected" of cell shader, so material stays shared. Selection
+   * material overrides material of instance instead if it's set
+   *
+   * @param p_instance - mesh instance of tile, bound to signal by Tile
+   */
   void handle_input_event(Camera3D* p_camera, const Ref<InputEvent>& p_event, const Vector3& p_event_position,
-                          const Vector3& p_normal, int32_t p_shape_idx);
+                          const Vector3& p_normal, int32_t p_shape_idx, MeshInstance3D* p_instance);
 };
 
 }  // namespace sota
@@ -2,19 +2,19 @@
 
 #include <algorithm>  // for max, min
 #include <memory>     // for make_unique
+#include <span>       // for span
 #include <vector>     // for vector
 
 #include "core/general_utility.h"  // for VolumeMeshProc...
 #include "core/hex_mesh.h"         // for HexMesh, HexMe...
 #include "core/mesh.h"             // for Orientation
+#include "core/noise_cache.h"      // for NoiseCache
 #include "misc/discretizer.h"      // for Dicretizer
 #include "misc/types.h"            // for GroupedMeshVer...
 #include "misc/utilities.h"        // for to_point_divis...
 #include "primitives/hexagon.h"    // for Hexagon, make_...
 #include "primitives/polygon.h"    // for RegularPolygon
-#include "tal/callable.h"          // for Callable
 #include "tal/godot_core.h"        // for D_METHOD, ClassDB
-#include "tal/noise.h"             // for FastNoiseLite
 #include "tal/reference.h"         // for Ref
 #include "tal/vector3.h"           // for Vector3
 
@@ -22,8 +22,8 @@ namespace sota {
 
 HoneycombHoney::HoneycombHoney(Hexagon hex, HoneycombHoneyMeshParams params)
     : _hex_mesh(Ref<HexMesh>(memnew(HexMesh(hex, params.hex_mesh_params)))) {
-  _hex_mesh->init();
-  _noise = params.noise;
+  // uploaded by owner on the main thread
+  _hex_mesh->build();
   _max_level = params.max_level;
   _fill_delta = params.fill_delta;
   _min_offset = params.min_offset;
@@ -44,14 +44,6 @@ void HoneycombHoney::_bind_methods() {
   ClassDB::bind_method(D_METHOD("is_empty"), &HoneycombHoney::is_empty);
 }
 
-void HoneycombHoney::set_noise(Ref<FastNoiseLite> p_noise) {
-  _noise = p_noise;
-  if (_noise.ptr()) {
-    _noise->connect("changed", Callable(this, "request_update"));
-    _hex_mesh->update();
-  }
-}
-
 void HoneycombHoney::set_min_offset(float p_offset) { _min_offset = p_offset; }
 
 void HoneycombHoney::set_max_level(float p_max_level) { _max_level = p_max_level; }
@@ -77,26 +69,26 @@ bool HoneycombHoney::is_empty() const { return _level == 0; }
 
 void HoneycombHoney::clear() {
   _level = 0;
-  auto vertices = _hex_mesh->get_vertices();
-  for (auto& v : vertices) {
-    v.y = _min_offset;
-  }
-  _hex_mesh->set_vertices(vertices);
-  _hex_mesh->calculate_normals();
+  _hex_mesh->edit_vertices([this](std::span<Vector3> vertices) {
+    for (auto& v : vertices) {
+      v.y = _min_offset;
+    }
+  });
   _hex_mesh->update();
 }
 
 int HoneycombHoney::get_level() const { return _level; }
 
-void HoneycombHoney::calculate_initial_heights() {
-  auto vertices = _hex_mesh->get_vertices();
-  for (auto& v : vertices) {
-    float n = _noise.ptr() ? _noise->get_noise_2d(v.x, v.z) : 0.0;
-    v.y = _hex_mesh->base().center().y + n;
-    _min_y = std::min(_min_y, v.y);
-    _max_y = std::max(_max_y, v.y);
-  }
-  _hex_mesh->set_vertices(vertices);
+void HoneycombHoney::calculate_initial_heights(const NoiseCache& noise) {
+  float center_y = _hex_mesh->base().center().y;
+  _hex_mesh->edit_vertices([this, &noise, center_y](std::span<Vector3> vertices) {
+    for (auto& v : vertices) {
+      float n = noise.get(v);
+      v.y = center_y + n;
+      _min_y = std::min(_min_y, v.y);
+      _max_y = std::max(_max_y, v.y);
+    }
+  });
 }
 
 void HoneycombHoney::set_shift_compress(float y_shift, float y_compress) {
@@ -108,17 +100,18 @@ void HoneycombHoney::calculate_heights() {
   if (!_processor) {
     print("processor of HoneycombHoney object is nullptr");
   }
-  _hex_mesh->set_vertices(
-      _processor->shift_compress(_hex_mesh->get_vertices(), _y_shift, _y_compress, _hex_mesh->base().center().y));
+  float center_y = _hex_mesh->base().center().y;
+  _hex_mesh->edit_vertices([this, center_y](std::span<Vector3> vertices) {
+    _processor->shift_compress(vertices, _y_shift, _y_compress, center_y);
+  });
 }
 
 void HoneycombHoney::recalculate_vertices_update(float surplus) {
-  auto vertices = _hex_mesh->get_vertices();
-  for (auto& v : vertices) {
-    v.y += surplus;
-  }
-  _hex_mesh->set_vertices(vertices);
-  _hex_mesh->calculate_normals();
+  _hex_mesh->edit_vertices([surplus](std::span<Vector3> vertices) {
+    for (auto& v : vertices) {
+      v.y += surplus;
+    }
+  });
   _hex_mesh->update();
 }
 
@@ -6,9 +6,9 @@
 
 #include "core/general_utility.h"  // for MeshProcessor
 #include "core/hex_mesh.h"         // for HexMesh, HexMeshParams
+#include "core/noise_cache.h"      // for NoiseCache
 #include "core/tile_mesh.h"        // for TileMesh
 #include "misc/types.h"            // for GroupedMeshVertices
-#include "tal/noise.h"             // for FastNoiseLite
 #include "tal/reference.h"         // for Ref
 
 namespace sota {
@@ -16,7 +16,6 @@ class Hexagon;
 
 struct HoneycombHoneyMeshParams {
   HexMeshParams hex_mesh_params;
-  Ref<FastNoiseLite> noise{nullptr};
   int max_level{0};
   float fill_delta{0};
   float min_offset{0.0};
@@ -36,7 +35,6 @@ class HoneycombHoney : public TileMesh {
   std::pair<float, float> get_min_max_height() const { return {_min_y, _max_y}; }
 
   // setters
-  void set_noise(Ref<FastNoiseLite> noise);
   void set_min_offset(float p_offset);
   void set_max_level(float p_max_level);
 
@@ -46,7 +44,8 @@ class HoneycombHoney : public TileMesh {
   void clear();
   int get_level() const;
 
-  void calculate_initial_heights();
+  // noise is read from cache shared by all tiles of honeycomb
+  void calculate_initial_heights(const NoiseCache& noise);
   void calculate_heights();
 
   void set_shift_compress(float y_shift, float y_compress);
@@ -66,7 +65,6 @@ class HoneycombHoney : public TileMesh {
   static void _bind_methods();
 
  private:
-  Ref<FastNoiseLite> _noise;
   int _level{0};
   int _max_level{0};
   float _fill_delta{0};
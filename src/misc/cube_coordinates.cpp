@@ -87,12 +87,20 @@ CubeCoordinates pixelToCube(float x, float y, float R) {
   return cubeRound(q, r, -q - r);
 }
 
-std::vector<CubeCoordinates> neighbours(CubeCoordinates current) {
-  return {
-      {current + unitCubeR() - unitCubeS()}, {current + unitCubeQ() - unitCubeS()},
-      {current + unitCubeQ() - unitCubeR()}, {current - unitCubeR() + unitCubeS()},
-      {current - unitCubeQ() + unitCubeS()}, {current - unitCubeQ() + unitCubeR()},
+CubeCoordinates cubeDirection(int i) {
+  static const CubeCoordinates directions[6] = {
+      {.q = 0, .r = 1, .s = -1}, {.q = 1, .r = 0, .s = -1}, {.q = 1, .r = -1, .s = 0},
+      {.q = 0, .r = -1, .s = 1}, {.q = -1, .r = 0, .s = 1}, {.q = -1, .r = 1, .s = 0},
   };
+  return directions[i];
+}
+
+std::vector<CubeCoordinates> neighbours(CubeCoordinates current) {
+  std::vector<CubeCoordinates> result;
+  for (int i = 0; i < 6; ++i) {
+    result.push_back(current + cubeDirection(i));
+  }
+  return result;
 }
 
 }  // namespace sota
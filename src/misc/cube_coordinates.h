@@ -34,6 +34,8 @@ CubeCoordinates unitCubeR();
 CubeCoordinates unitCubeS();
 CubeCoordinates cubeRound(float frac_q, float frac_r, float frac_s);
 CubeCoordinates pixelToCube(float x, float y, float R);
+// offset to i-th neighbour, in the same order as neighbours() returns them
+CubeCoordinates cubeDirection(int i);
 std::vector<CubeCoordinates> neighbours(CubeCoordinates current);
 
 }  // namespace sota
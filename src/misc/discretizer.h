@@ -12,7 +12,17 @@ namespace sota {
 using DiscreteVertex = Vector3i;
 using Distance = float;
 using DiscreteVertexToDistance = std::map<DiscreteVertex, Distance>;
-using DiscreteVertexToNormals = std::map<DiscreteVertex, std::vector<Vector3*>>;
+// indices of vertices of one mesh, their normals are stored at the same indices
+using DiscreteVertexToNormals = std::map<DiscreteVertex, std::vector<int>>;
+
+/**
+ * @brief Distance stored for vertex or 0 if there is none. Unlike operator[] doesn't insert, so map can be read by
+ * several threads at once
+ */
+inline Distance find_distance(const DiscreteVertexToDistance& distance_map, DiscreteVertex vertex) {
+  auto it = distance_map.find(vertex);
+  return it != distance_map.end() ? it->second : 0;
+}
 
 class VertexToNormalDiscretizer {
  public:
@@ -20,13 +30,11 @@ class VertexToNormalDiscretizer {
 
   static DiscreteVertex get_discrete_vertex(Vector3 v, float step);
 
-  void discretize(Vector3Array vertices, std::vector<Vector3>& normals) {
+  void discretize(const Vector3Array& vertices) {
     int size = vertices.size();
+    const Vector3* v = vertices.ptr();
     for (int i = 0; i < size; ++i) {
-      Vector3 v = vertices[i];
-      Vector3& n = normals[i];
-      auto p = get_discrete_vertex(v, _step);
-      _discretized[p].push_back(&n);
+      _discretized[get_discrete_vertex(v[i], _step)].push_back(i);
     }
   }
 
@@ -13,44 +13,123 @@
 
 namespace sota {
 
+namespace {
+float bounding_radius(const Ref<TileMesh>& mesh) {
+  auto points = mesh->inner_mesh()->base().points();
+  return mesh->inner_mesh()->base().center().distance_to(points[0]);
+}
+}  // namespace
+
 // Tile definitions
 Tile::~Tile() {}
 
-Tile::Tile(Ref<TileMesh> mesh, Vector3 offset, Node3D* parent, OffsetCoordinates offset_coord)
-    : _mesh(mesh), _offset_coord(offset_coord), _shifted(is_odd(offset_coord.row)) {
+Tile::Tile(Ref<TileMesh> mesh, Vector3 offset, OffsetCoordinates offset_coord)
+    : _mesh(mesh), _offset(offset), _offset_coord(offset_coord), _shifted(is_odd(offset_coord.row)) {}
+
+Ref<TileMesh> Tile::mesh() const { return _mesh; }
+
+void Tile::attach(Node3D* parent, bool batched, bool physics_body) {
+  if (_parent) {
+    // way tile is drawn is kept, see HexGrid::can_reuse_tiles()
+    show_mesh();
+  } else {
+    _parent = parent;
+    if (!batched) {
+      create_nodes(physics_body);
+    }
+  }
+  if (_main_mesh_instance) {
+    _mesh->inner_mesh()->update();
+  }
+}
+
+void Tile::create_nodes(bool physics_body) {
   _main_mesh_instance = memnew(MeshInstance3D());
-  _sphere_shaped3d = Ref<SphereShape3D>(memnew(SphereShape3D()));
+  _main_mesh_instance->set_mesh(_mesh->inner_mesh());
+  _parent->add_child(_main_mesh_instance);
+  _shown_mesh = _mesh;
+#ifdef SOTA_ENGINE
+  Node* root_scene = EditorInterface::get_singleton()->get_edited_scene_root();
+  _main_mesh_instance->set_owner(root_scene);
+#endif
+  if (!physics_body) {
+    return;
+  }
 
-  auto points = mesh->inner_mesh()->base().points();
-  auto center = mesh->inner_mesh()->base().center();
-  _sphere_shaped3d->set_radius(center.distance_to(points[0]));
+  _sphere_shaped3d = Ref<SphereShape3D>(memnew(SphereShape3D()));
+  _sphere_shaped3d->set_radius(bounding_radius(_mesh));
 
   _collision_shape3d = memnew(CollisionShape3D());
   _collision_shape3d->set_shape(_sphere_shaped3d);
 
   _static_body = memnew(StaticBody3D());
-  _static_body->set_position(offset);
-
-  _main_mesh_instance->set_mesh(mesh->inner_mesh());
-
-  add_child(_main_mesh_instance);
-  parent->add_child(this);
+  _static_body->set_position(_offset);
 
   _main_mesh_instance->add_child(_static_body);
   _static_body->add_child(_collision_shape3d);
 #ifdef SOTA_ENGINE
-  Node* root_scene = EditorInterface::get_singleton()->get_edited_scene_root();
-  _main_mesh_instance->set_owner(root_scene);
   _static_body->set_owner(root_scene);
   _collision_shape3d->set_owner(root_scene);
 #endif
 
+  connect_mesh(_mesh);
+}
+
+void Tile::show_mesh() {
+  bool replaced = _shown_mesh.ptr() != _mesh.ptr();
+  if (_main_mesh_instance && replaced) {
+    _main_mesh_instance->set_mesh(_mesh->inner_mesh());
+  }
+  if (_static_body) {
+    if (replaced) {
+      disconnect_mesh(_shown_mesh);
+      connect_mesh(_mesh);
+    }
+    // mesh reset in place could change its size
+    _static_body->set_position(_offset);
+    _sphere_shaped3d->set_radius(bounding_radius(_mesh));
+  }
+  _shown_mesh = _mesh;
+}
+
+void Tile::detach() {
+  if (_main_mesh_instance) {
+    // collision body is a child of mesh instance
+    _parent->remove_child(_main_mesh_instance);
+    _main_mesh_instance->queue_free();
+  }
+  _main_mesh_instance = nullptr;
+  _static_body = nullptr;
+  _collision_shape3d = nullptr;
+  _sphere_shaped3d = Ref<SphereShape3D>();
+  _shown_mesh = Ref<TileMesh>();
+  _parent = nullptr;
+}
+
+void Tile::reuse(Ref<TileMesh> mesh, Vector3 offset) {
+  _mesh = mesh;
+  _offset = offset;
+}
+
+void Tile::connect_mesh(Ref<TileMesh> mesh) {
   _static_body->connect("mouse_entered", Callable(mesh.ptr(), "handle_mouse_entered"));
   _static_body->connect("mouse_exited", Callable(mesh.ptr(), "handle_mouse_exited"));
-  _static_body->connect("input_event", Callable(mesh.ptr(), "handle_input_event"));
+  _static_body->connect("input_event", Callable(mesh.ptr(), "handle_input_event").bind(_main_mesh_instance));
 }
 
-Ref<TileMesh> Tile::mesh() const { return _mesh; }
+void Tile::disconnect_mesh(Ref<TileMesh> mesh) {
+  _static_body->disconnect("mouse_entered", Callable(mesh.ptr(), "handle_mouse_entered"));
+  _static_body->disconnect("mouse_exited", Callable(mesh.ptr(), "handle_mouse_exited"));
+  _static_body->disconnect("input_event", Callable(mesh.ptr(), "handle_input_event").bind(_main_mesh_instance));
+}
+
+void Tile::set_lod_parent(MeshInstance3D* lod_parent) {
+  if (!_main_mesh_instance) {
+    // batched tile, levels of detail aren't supported by chunks
+    return;
+  }
+  _main_mesh_instance->set_visibility_parent(lod_parent ? _main_mesh_instance->get_path_to(lod_parent) : NodePath());
+}
 
 // BiomeTile definitions
 Biome BiomeTile::biome() const { return _biome; }
@@ -58,16 +137,37 @@ Biome BiomeTile::biome() const { return _biome; }
 Neighbours BiomeTile::neighbours() const { return _neighbours; }
 void BiomeTile::set_neighbours(Neighbours neighbours) { _neighbours = neighbours; }
 
+void BiomeTile::reuse(Ref<RidgeMesh> ridge_hex_mesh, Biome biome) {
+  Tile::reuse(ridge_hex_mesh, ridge_hex_mesh->get_center());
+  _biome = biome;
+  _neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+}
+
 // HoneycombTile definitions
 Ref<HoneycombHoney> HoneycombTile::honey_mesh() const { return _honey; }
-HoneycombTile::HoneycombTile(Ref<HoneycombCell> walls, Ref<HoneycombHoney> honey, Node3D* parent,
-                             OffsetCoordinates offset_coord)
-    : Tile(walls, walls->inner_mesh()->get_center(), parent, offset_coord), _honey(honey) {
-  _second_mesh_instance = memnew(MeshInstance3D());
-
-  _second_mesh_instance->set_mesh(honey->inner_mesh());
+HoneycombTile::HoneycombTile(Ref<HoneycombCell> walls, Ref<HoneycombHoney> honey, OffsetCoordinates offset_coord)
+    : Tile(walls, walls->inner_mesh()->get_center(), offset_coord), _honey(honey) {}
+
+void HoneycombTile::attach(Node3D* parent, bool batched, bool physics_body) {
+  Tile::attach(parent, batched, physics_body);
+  if (batched) {
+    return;
+  }
+  if (!_second_mesh_instance) {
+    _second_mesh_instance = memnew(MeshInstance3D());
+    _second_mesh_instance->set_mesh(_honey->inner_mesh());
+    parent->add_child(_second_mesh_instance);
+  }
+  _honey->inner_mesh()->update();
+}
 
-  parent->add_child(_second_mesh_instance);
+void HoneycombTile::detach() {
+  if (_second_mesh_instance) {
+    _second_mesh_instance->get_parent()->remove_child(_second_mesh_instance);
+    _second_mesh_instance->queue_free();
+    _second_mesh_instance = nullptr;
+  }
+  Tile::detach();
 }
 
 }  // namespace sota
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "core/hex_mesh.h"
 #include "honeycomb/honeycomb_cell.h"
@@ -14,35 +15,82 @@
 
 namespace sota {
 
-class Tile : public Node3D {
+/**
+ * @brief Mesh of grid at offset coordinates. Tile is plain data, so grid may build it on background thread. Nodes
+ * drawing it are created by attach() on the main thread
+ */
+class Tile {
  public:
   Tile() = delete;
+  Tile(const Tile& other) = delete;
+  Tile& operator=(const Tile& other) = delete;
+  /**
+   * @brief Nodes of attached tile are owned by its parent, they are deleted by detach() or together with parent
+   */
   virtual ~Tile();
 
-  Tile(Ref<TileMesh> mesh, Vector3 offset, Node3D* parent, OffsetCoordinates offset_coord);
+  Tile(Ref<TileMesh> mesh, Vector3 offset, OffsetCoordinates offset_coord);
 
   Ref<TileMesh> mesh() const;
+  // null if tile is drawn by chunk or isn't attached
+  MeshInstance3D* mesh_instance() const { return _main_mesh_instance; }
+  bool has_physics_body() const { return _static_body != nullptr; }
+  bool is_attached() const { return _parent != nullptr; }
   int id() const { return _mesh->get_id(); }
   bool is_shifted() const { return _shifted; }
   OffsetCoordinates get_offset_coords() const { return _offset_coord; }
   CubeCoordinates get_cube_coords() const { return offsetToCube(_offset_coord); }
 
+  /**
+   * @brief Creates nodes drawing tile under parent and uploads its meshes. Nodes of tile attached before show its
+   * current mesh then, see reuse(). Called on the main thread
+   *
+   * @param batched - mesh is drawn by Chunk, so tile doesn't create its own mesh instance and collision body
+   * @param physics_body - mouse events are delivered by collision body of tile, otherwise by TilePicker of grid
+   */
+  virtual void attach(Node3D* parent, bool batched, bool physics_body);
+  /**
+   * @brief Deletes nodes of tile. Called on the main thread
+   */
+  virtual void detach();
+
+  /**
+   * @brief Hides mesh of tile while lod_parent is within its visibility range, see HexGrid::init_lods(). Null shows
+   * mesh at any distance
+   */
+  void set_lod_parent(MeshInstance3D* lod_parent);
+
+  /**
+   * @brief Replaces mesh at the same coordinates, so nodes of tile are reused by next generation of grid instead of
+   * being created again. Nodes show new mesh after next attach()
+   */
+  void reuse(Ref<TileMesh> mesh, Vector3 offset);
+
  private:
   Ref<SphereShape3D> _sphere_shaped3d{nullptr};
   CollisionShape3D* _collision_shape3d{nullptr};
   StaticBody3D* _static_body{nullptr};
   MeshInstance3D* _main_mesh_instance{nullptr};
+  Node3D* _parent{nullptr};
 
   Ref<TileMesh> _mesh;
+  // mesh shown by nodes, differs from _mesh until reused tile is attached again
+  Ref<TileMesh> _shown_mesh;
+  Vector3 _offset;
   OffsetCoordinates _offset_coord;
   const bool _shifted;  // odd rows are shifted by half of small radius
+
+  void create_nodes(bool physics_body);
+  void show_mesh();
+  void connect_mesh(Ref<TileMesh> mesh);
+  void disconnect_mesh(Ref<TileMesh> mesh);
 };
 
 class BiomeTile : public Tile {
  public:
   BiomeTile() = delete;
-  BiomeTile(Ref<RidgeMesh> ridge_hex_mesh, Node3D* parent, Biome biome, OffsetCoordinates offset_coord)
-      : Tile(ridge_hex_mesh, ridge_hex_mesh->get_center(), parent, offset_coord), _biome(biome) {}
+  BiomeTile(Ref<RidgeMesh> ridge_hex_mesh, Biome biome, OffsetCoordinates offset_coord)
+      : Tile(ridge_hex_mesh, ridge_hex_mesh->get_center(), offset_coord), _biome(biome) {}
 
   // getters
   Biome biome() const;
@@ -51,6 +99,8 @@ class BiomeTile : public Tile {
   // setters
   void set_neighbours(Neighbours neighbours);
 
+  void reuse(Ref<RidgeMesh> ridge_hex_mesh, Biome biome);
+
  private:
   Biome _biome;
   Neighbours _neighbours;
@@ -59,11 +109,14 @@ class BiomeTile : public Tile {
 class HoneycombTile : public Tile {
  public:
   HoneycombTile() = delete;
-  HoneycombTile(Ref<HoneycombCell> walls, Ref<HoneycombHoney> honey, Node3D* parent, OffsetCoordinates offset_coord);
+  HoneycombTile(Ref<HoneycombCell> walls, Ref<HoneycombHoney> honey, OffsetCoordinates offset_coord);
 
   // getters
   Ref<HoneycombHoney> honey_mesh() const;
 
+  void attach(Node3D* parent, bool batched, bool physics_body) override;
+  void detach() override;
+
  private:
   Ref<HoneycombHoney> _honey;
   MeshInstance3D* _second_mesh_instance{nullptr};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>  // for min, max
+#include <array>      // for array
+#include <utility>    // for pair
+#include <vector>     // for vector
+
+#include "misc/cube_coordinates.h"  // for CubeCoordinates, cubeDirection
+
+namespace sota {
+
+/**
+ * @brief Dense index of tiles over axial coordinates (q, r) of cube coordinates. Storage is bounding box of indexed
+ * tiles, so lookup is O(1) and lookup of missing tile or of coordinates out of bounds returns nullptr without
+ * inserting anything
+ */
+template <typename T>
+class TileIndex {
+ public:
+  TileIndex() = default;
+
+  /**
+   * @brief Replaces content of index. Bounds are calculated from given coordinates
+   */
+  void assign(const std::vector<std::pair<CubeCoordinates, T*>>& tiles) {
+    clear();
+    if (tiles.empty()) {
+      return;
+    }
+    int max_q = tiles.front().first.q;
+    int max_r = tiles.front().first.r;
+    _min_q = max_q;
+    _min_r = max_r;
+    for (const auto& [coords, tile] : tiles) {
+      _min_q = std::min(_min_q, coords.q);
+      _min_r = std::min(_min_r, coords.r);
+      max_q = std::max(max_q, coords.q);
+      max_r = std::max(max_r, coords.r);
+    }
+    _width = max_q - _min_q + 1;
+    _height = max_r - _min_r + 1;
+    _tiles.assign(_width * _height, nullptr);
+    for (const auto& [coords, tile] : tiles) {
+      _tiles[flat(coords)] = tile;
+    }
+  }
+
+  void clear() {
+    _tiles.clear();
+    _width = 0;
+    _height = 0;
+  }
+
+  T* at(CubeCoordinates coords) const {
+    int i = flat(coords);
+    return i < 0 ? nullptr : _tiles[i];
+  }
+
+  bool contains(CubeCoordinates coords) const { return at(coords) != nullptr; }
+
+  /**
+   * @brief Tiles adjacent to the given one, in the same order as neighbours(CubeCoordinates). Missing ones are nullptr
+   */
+  std::array<T*, 6> neighbours(CubeCoordinates coords) const {
+    std::array<T*, 6> result;
+    for (int i = 0; i < 6; ++i) {
+      result[i] = at(coords + cubeDirection(i));
+    }
+    return result;
+  }
+
+ private:
+  std::vector<T*> _tiles;
+  int _min_q{0};
+  int _min_r{0};
+  int _width{0};
+  int _height{0};
+
+  // -1 if coordinates are out of bounds
+  int flat(CubeCoordinates coords) const {
+    int q = coords.q - _min_q;
+    int r = coords.r - _min_r;
+    if (q < 0 || q >= _width || r < 0 || r >= _height) {
+      return -1;
+    }
+    return r * _width + q;
+  }
+};
+
+}  // namespace sota
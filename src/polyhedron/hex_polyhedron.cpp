@@ -10,11 +10,14 @@
 #include <vector>
 
 #include "algo/constants.h"    // for PI
-#include "core/godot_utils.h"  // for clean_children
+#include "core/chunk.h"        // for Chunk
+#include "core/godot_utils.h"  // for clean_children, reconnect_changed
+#include "core/tile_picker.h"  // for TilePicker, TilePick
 #include "core/utils.h"        // for map2d_to_3d, ico_in...
 #include "cube_coordinates.h"
 #include "discretizer.h"
 #include "misc/biome_calculator.h"  // for BiomeCalculator
+#include "misc/tile_index.h"        // for TileIndex
 #include "misc/types.h"             // for Biome, Biome::HILL
 #include "polygon.h"
 #include "primitives/hexagon.h"   // for Hexagon
@@ -23,9 +26,11 @@
 #include "tal/callable.h"         // for Callable
 #include "tal/godot_core.h"       // for D_METHOD, ClassDB
 #include "tal/material.h"         // for ShaderMaterial
+#include "tal/mesh.h"             // for MeshInstance3D
 #include "tal/noise.h"            // for FastNoiseLite
 #include "tal/shader.h"           // for Shader
 #include "tal/texture.h"          // for Texture
+#include "tal/transform3d.h"      // for Transform3D
 #include "tal/vector2.h"          // for Vector2
 #include "tal/vector3.h"          // for Vector3
 #include "tal/vector3i.h"         // for Vector3i
@@ -43,11 +48,28 @@ Polyhedron::Polyhedron() {
 
 void Polyhedron::_bind_methods() {
   ClassDB::bind_method(D_METHOD("init"), &Polyhedron::init);
+  ClassDB::bind_method(D_METHOD("request_init"), &Polyhedron::request_init);
+  ClassDB::bind_method(D_METHOD("deferred_init"), &Polyhedron::deferred_init);
+  ClassDB::bind_method(D_METHOD("generate_async"), &Polyhedron::generate_async);
+  ClassDB::bind_method(D_METHOD("finish_generation"), &Polyhedron::finish_generation);
+  ClassDB::bind_method(D_METHOD("is_generating"), &Polyhedron::is_generating);
+  ADD_SIGNAL(MethodInfo("progress", PropertyInfo(Variant::FLOAT, "ratio")));
+  ADD_SIGNAL(MethodInfo("finished"));
 
   ClassDB::bind_method(D_METHOD("get_patch_resolution"), &Polyhedron::get_patch_resolution);
   ClassDB::bind_method(D_METHOD("set_patch_resolution", "p_patch_resolution"), &Polyhedron::set_patch_resolution);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "patch_resolution"), "set_patch_resolution", "get_patch_resolution");
 
+  ClassDB::bind_method(D_METHOD("get_chunk_size"), &Polyhedron::get_chunk_size);
+  ClassDB::bind_method(D_METHOD("set_chunk_size", "p_chunk_size"), &Polyhedron::set_chunk_size);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "chunk_size"), "set_chunk_size", "get_chunk_size");
+
+  ClassDB::bind_method(D_METHOD("get_analytic_picking"), &Polyhedron::get_analytic_picking);
+  ClassDB::bind_method(D_METHOD("set_analytic_picking", "p_analytic_picking"), &Polyhedron::set_analytic_picking);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "analytic_picking"), "set_analytic_picking", "get_analytic_picking");
+
+  ClassDB::bind_method(D_METHOD("pick_tile", "origin", "direction"), &Polyhedron::pick_tile);
+
   ClassDB::bind_method(D_METHOD("get_divisions"), &Polyhedron::get_divisions);
   ClassDB::bind_method(D_METHOD("set_divisions", "p_divisions"), &Polyhedron::set_divisions);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "divisions"), "set_divisions", "get_divisions");
@@ -85,51 +107,93 @@ void Polyhedron::_bind_methods() {
 }
 
 void Polyhedron::set_divisions(const int p_divisions) {
+  if (queue_if_generating("set_divisions", p_divisions)) {
+    return;
+  }
   _divisions = p_divisions > 1 ? p_divisions : 1;
-  init();
+  request_init();
 }
 
 void Polyhedron::set_patch_resolution(const int p_patch_resolution) {
+  if (queue_if_generating("set_patch_resolution", p_patch_resolution)) {
+    return;
+  }
   _patch_resolution = p_patch_resolution;
-  init();
+  request_init();
+}
+
+void Polyhedron::set_chunk_size(const int p_chunk_size) {
+  if (queue_if_generating("set_chunk_size", p_chunk_size)) {
+    return;
+  }
+  _chunk_size = p_chunk_size > 0 ? p_chunk_size : 0;
+  request_init();
+}
+
+void Polyhedron::set_analytic_picking(const bool p_analytic_picking) {
+  if (queue_if_generating("set_analytic_picking", p_analytic_picking)) {
+    return;
+  }
+  _analytic_picking = p_analytic_picking;
+  set_process_unhandled_input(_analytic_picking);
 }
 
 void Polyhedron::set_shader(const Ref<Shader> p_shader) {
+  if (queue_if_generating("set_shader", p_shader)) {
+    return;
+  }
   _shader = p_shader;
-  init();
+  request_init();
 }
 
 void Polyhedron::set_biomes_noise(const Ref<FastNoiseLite> p_biomes_noise) {
+  if (queue_if_generating("set_biomes_noise", p_biomes_noise)) {
+    return;
+  }
+  reconnect_changed(_biomes_noise.ptr(), p_biomes_noise.ptr(), Callable(this, "request_init"));
   _biomes_noise = p_biomes_noise;
   if (_biomes_noise.ptr()) {
-    _biomes_noise->connect("changed", Callable(this, "init"));
-    init();
+    request_init();
   }
 }
 
 // TODO: textures code copypasted from RidgeHexGridMap
 void Polyhedron::set_plain_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_plain_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::PLAIN] = p_texture;
-  init();
+  request_init();
 }
 
 void Polyhedron::set_hill_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_hill_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::HILL] = p_texture;
-  init();
+  request_init();
 }
 
 void Polyhedron::set_water_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_water_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::WATER] = p_texture;
-  init();
+  request_init();
 }
 
 void Polyhedron::set_mountain_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_mountain_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::MOUNTAIN] = p_texture;
-  init();
+  request_init();
 }
 
 int Polyhedron::get_divisions() const { return _divisions; }
 int Polyhedron::get_patch_resolution() const { return _patch_resolution; }
+int Polyhedron::get_chunk_size() const { return _chunk_size; }
+bool Polyhedron::get_analytic_picking() const { return _analytic_picking; }
 Ref<Shader> Polyhedron::get_shader() const { return _shader; }
 Ref<FastNoiseLite> Polyhedron::get_biomes_noise() const { return _biomes_noise; }
 Ref<Texture> Polyhedron::get_plain_texture() const { return _texture.find(Biome::PLAIN)->second; }
@@ -193,9 +257,10 @@ std::pair<std::vector<PolygonWrapper>, std::vector<PolygonWrapper>> Polyhedron::
 
   std::map<Vector3i, PolygonWrapper> hexagon_map;
   std::map<Vector3i, PolygonWrapper> pentagon_map;
-  std::map<CubeCoordinates, PolygonWrapper*> cube_to_discrete_vertex;
+  std::vector<std::pair<CubeCoordinates, PolygonWrapper*>> patch;
+  TileIndex<PolygonWrapper> patch_index;
   for (int t = 0; t < 20; ++t) {
-    cube_to_discrete_vertex.clear();
+    patch.clear();
     Vector3i triangle = indices[t];
     for (int i = 0; i < _patch_resolution + 2; ++i) {
       for (int j = 0; j < _patch_resolution + 2; ++j) {
@@ -208,15 +273,16 @@ std::pair<std::vector<PolygonWrapper>, std::vector<PolygonWrapper>> Polyhedron::
               insert_to_polygons<Hexagon>(start_point, diameter, R, r, i, j, icosahedron_points, triangle, hexagon_map);
         }
         if (opt_key) {
-          cube_to_discrete_vertex[offsetToCube(OffsetCoordinates{.row = i, .col = j})] = opt_key.value();
+          patch.emplace_back(offsetToCube(OffsetCoordinates{.row = i, .col = j}), opt_key.value());
         }
       }
     }
 
-    for (auto [cube_coords, wrapper_ptr] : cube_to_discrete_vertex) {
-      for (auto n : neighbours(cube_coords)) {
-        if (cube_to_discrete_vertex.contains(n)) {
-          _neighbours_map[wrapper_ptr->id()].insert(cube_to_discrete_vertex[n]->id());
+    patch_index.assign(patch);
+    for (auto [cube_coords, wrapper_ptr] : patch) {
+      for (PolygonWrapper* n : patch_index.neighbours(cube_coords)) {
+        if (n) {
+          _neighbours_map[wrapper_ptr->id()].insert(n->id());
         }
       }
     }
@@ -257,8 +323,22 @@ void Polyhedron::clear() {
   _hexagons.clear();
   _pentagons.clear();
   _neighbours_map.clear();
+  _picker.reset();
+}
 
-  clean_children(*this);
+void Polyhedron::init_materials() {
+  _materials.clear();
+  // parameters of material don't depend on biome, so all polygons share it
+  _materials.get(_shader, 0, [this](Ref<ShaderMaterial> material) {
+    if (_texture.size() == 4) {
+      material->set_shader_parameter("water_texture", _texture[Biome::WATER].ptr());
+      material->set_shader_parameter("plain_texture", _texture[Biome::PLAIN].ptr());
+      material->set_shader_parameter("hill_texture", _texture[Biome::HILL].ptr());
+      material->set_shader_parameter("mountain_texture", _texture[Biome::MOUNTAIN].ptr());
+    }
+
+    set_material_parameters(material);
+  });
 }
 
 template <typename T>
@@ -281,24 +361,10 @@ void Polyhedron::process_ngons(std::vector<PolygonWrapper>& ngons, float min_z,
 
   id = 0;
   BiomeCalculator biome_calculator;
+  Ref<ShaderMaterial> mat = _materials.find(_shader, 0);
   for (PolygonWrapper& ngon : ngons) {
     Biome biome = biome_calculator.calculate_biome(min_z, max_z, altitudes[id]);
 
-    Ref<ShaderMaterial> mat;
-    mat.instantiate();
-    if (_shader.ptr()) {
-      mat->set_shader(_shader);
-    }
-
-    if (_texture.size() == 4) {
-      mat->set_shader_parameter("water_texture", _texture[Biome::WATER].ptr());
-      mat->set_shader_parameter("plain_texture", _texture[Biome::PLAIN].ptr());
-      mat->set_shader_parameter("hill_texture", _texture[Biome::HILL].ptr());
-      mat->set_shader_parameter("mountain_texture", _texture[Biome::MOUNTAIN].ptr());
-    }
-
-    set_material_parameters(mat);
-
     if constexpr (std::is_same_v<T, Hexagon>) {
       configure_hexagon(ngon, biome, id, mat);
     } else {
@@ -307,7 +373,64 @@ void Polyhedron::process_ngons(std::vector<PolygonWrapper>& ngons, float min_z,
   }
 }
 
+void Polyhedron::request_init() {
+  if (!_init_requested) {
+    _init_requested = true;
+    call_deferred("deferred_init");
+  }
+}
+
+void Polyhedron::deferred_init() {
+  if (!_init_requested) {
+    // request was covered by generate_async()
+    return;
+  }
+  _init_requested = false;
+  init();
+}
+
 void Polyhedron::init() {
+  if (is_generating()) {
+    _init_postponed = true;
+    return;
+  }
+  init_materials();
+  generate();
+  publish();
+}
+
+void Polyhedron::generate_async() {
+  if (is_generating()) {
+    printerr("Generation of polyhedron is already running");
+    return;
+  }
+  // pending requests are covered by generation
+  _init_requested = false;
+  _init_postponed = false;
+  init_materials();
+  _generation.start(*this, [this]() { generate(); });
+}
+
+void Polyhedron::finish_generation() {
+  if (!_generation.finish([this]() { publish(); })) {
+    // nothing was running, e.g. call from script
+    return;
+  }
+  emit_signal("finished");
+  if (_init_postponed) {
+    _init_postponed = false;
+    init();
+  }
+}
+
+void Polyhedron::_notification(int p_what) {
+  if (p_what == NOTIFICATION_PREDELETE) {
+    // background thread uses members of subclasses, which are destroyed before members of this class
+    _generation.cancel();
+  }
+}
+
+void Polyhedron::generate() {
   clear();
 
   std::pair<std::vector<PolygonWrapper>, std::vector<PolygonWrapper>> shapes = std::move(calculate_shapes());
@@ -318,9 +441,102 @@ void Polyhedron::init() {
   float max_z = std::numeric_limits<float>::min();
   process_ngons<Hexagon>(_hexagons, min_z, max_z);
   process_ngons<Pentagon>(_pentagons, min_z, max_z);
+  _generation.report_progress(0.3);
+  if (_generation.is_cancelled()) {
+    return;
+  }
 
   process_cells();
+  _generation.report_progress(0.8);
+  if (_generation.is_cancelled()) {
+    return;
+  }
   calculate_normals();
 }
 
+void Polyhedron::publish() {
+  // nodes of old tiles are replaced in one frame
+  clean_children(*this);
+  if (_chunk_size > 0) {
+    init_chunks();
+    return;
+  }
+  for (std::vector<PolygonWrapper>* ngons : {&_hexagons, &_pentagons}) {
+    for (PolygonWrapper& wrapper : *ngons) {
+      add_tile_instance(wrapper.mesh()->inner_mesh());
+    }
+  }
+}
+
+void Polyhedron::add_tile_instance(SotaMesh* mesh) {
+  auto* mi = memnew(MeshInstance3D());
+  mi->set_mesh(mesh);
+  add_child(mi);
+  mesh->update();
+}
+
+void Polyhedron::init_chunks() {
+  // neighbouring polygons are created one after another, see calculate_shapes
+  for (std::vector<PolygonWrapper>* ngons : {&_hexagons, &_pentagons}) {
+    int size = ngons->size();
+    for (int first = 0; first < size; first += _chunk_size) {
+      std::vector<Ref<SotaMesh>> meshes;
+      for (int i = first; i < std::min(first + _chunk_size, size); ++i) {
+        meshes.push_back(Ref<SotaMesh>((*ngons)[i].mesh()->inner_mesh()));
+      }
+      memnew(Chunk(std::move(meshes), this));
+    }
+  }
+}
+
+#ifdef SOTA_GDEXTENSION
+void Polyhedron::_unhandled_input(const Ref<InputEvent>& p_event) {
+#else
+void Polyhedron::unhandled_input(const Ref<InputEvent>& p_event) {
+#endif
+  if (!_analytic_picking || is_generating()) {
+    return;
+  }
+  _picker.handle_input(get_viewport(), p_event,
+                       [this](Vector3 origin, Vector3 direction) { return pick(origin, direction); });
+}
+
+Ref<TileMesh> Polyhedron::pick_tile(Vector3 origin, Vector3 direction) const {
+  std::optional<TilePick> picked = pick(origin, direction);
+  return picked ? Ref<TileMesh>(picked->mesh) : Ref<TileMesh>();
+}
+
+std::optional<TilePick> Polyhedron::pick(Vector3 origin, Vector3 direction) const {
+  if (is_generating() || _hexagons.empty()) {
+    return std::nullopt;
+  }
+  Transform3D to_local = get_global_transform().affine_inverse();
+  Vector3 local_origin = to_local.xform(origin);
+  Vector3 local_direction = to_local.xform(origin + direction) - local_origin;
+  float radius = const_cast<PolygonWrapper&>(_hexagons.front()).polygon()->center().length();
+  std::optional<float> t = TilePicker::intersect_sphere(local_origin, local_direction, radius);
+  if (!t) {
+    return std::nullopt;
+  }
+
+  // polygon with the closest center in direction of hit point
+  Vector3 hit = (local_origin + local_direction * *t).normalized();
+  const PolygonWrapper* closest = nullptr;
+  float max_dot = -2;
+  for (const std::vector<PolygonWrapper>* ngons : {&_hexagons, &_pentagons}) {
+    for (const PolygonWrapper& ngon : *ngons) {
+      float dot = const_cast<PolygonWrapper&>(ngon).polygon()->center().normalized().dot(hit);
+      if (dot > max_dot) {
+        max_dot = dot;
+        closest = &ngon;
+      }
+    }
+  }
+  Ref<TileMesh> mesh = const_cast<PolygonWrapper*>(closest)->mesh();
+  Vector3 position = origin + direction * *t;
+  return TilePick{.mesh = mesh.ptr(),
+                  .position = position,
+                  .normal = (position - get_global_transform().xform(Vector3(0, 0, 0))).normalized()};
+}
+
 }  // namespace sota
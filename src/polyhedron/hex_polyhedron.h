@@ -7,7 +7,10 @@
 #include <utility>        // for pair
 #include <vector>         // for vector
 
-#include "core/tile_mesh.h"  // for TileMesh
+#include "core/async_generation.h"  // for AsyncGeneration
+#include "core/material_cache.h"    // for MaterialCache
+#include "core/tile_mesh.h"         // for TileMesh
+#include "core/tile_picker.h"       // for TilePicker, TilePick
 #include "discretizer.h"
 #include "misc/types.h"  // for Biome
 #include "polygon.h"
@@ -17,8 +20,10 @@
 #include "polyhedron/polyhedron_ridge_processor.h"
 #include "primitives/hexagon.h"
 #include "primitives/pentagon.h"
-#include "tal/arrays.h"    // for Vector3Array
-#include "tal/material.h"  // for ShaderMaterial
+#include "tal/arrays.h"      // for Vector3Array
+#include "tal/event.h"       // for InputEvent
+#include "tal/godot_core.h"  // for Variant
+#include "tal/material.h"    // for ShaderMaterial
 #include "tal/mesh.h"
 #include "tal/node.h"       // for Node3D
 #include "tal/noise.h"      // for FastNoiseLite
@@ -71,6 +76,40 @@ class Polyhedron : public Node3D {
   void set_patch_resolution(const int p_patch_resolution);
   int get_patch_resolution() const;
 
+  /**
+   * @brief Property shared with Godot inspector. Number of consecutive tiles drawn as single surface, see Chunk. 0
+   * means every tile has its own mesh instance
+   */
+  void set_chunk_size(const int p_chunk_size);
+  int get_chunk_size() const;
+
+  /**
+   * @brief Property shared with Godot inspector. If set, mouse events are delivered to tile hit by ray of camera.
+   * Ray is intersected with sphere going through centers of polygons
+   */
+  void set_analytic_picking(const bool p_analytic_picking);
+  bool get_analytic_picking() const;
+
+  /**
+   * @brief Tile mesh hit by ray given in global space, null if there is no tile
+   */
+  Ref<TileMesh> pick_tile(Vector3 origin, Vector3 direction) const;
+
+  /**
+   * @brief Builds tiles on background thread, "progress" signal reports share of work done. New tiles replace old
+   * ones in one frame and "finished" is emitted then, old tiles are visible until that. Properties set while
+   * generation is running are applied after it's finished, init() requested meanwhile is postponed as well
+   */
+  void generate_async();
+  void finish_generation();
+  bool is_generating() const { return _generation.is_running(); }
+
+#ifdef SOTA_GDEXTENSION
+  void _unhandled_input(const Ref<InputEvent>& p_event) override;
+#else
+  void unhandled_input(const Ref<InputEvent>& p_event) override;
+#endif
+
   void set_shader(const Ref<Shader> p_shader);
   Ref<Shader> get_shader() const;
 
@@ -97,8 +136,11 @@ class Polyhedron : public Node3D {
 
   std::vector<PolygonWrapper> _hexagons;
   std::vector<PolygonWrapper> _pentagons;
+  // materials are shared by tiles, created by init_materials()
+  MaterialCache _materials;
 
   static void _bind_methods();
+  void _notification(int p_what);
 
   virtual void configure_hexagon(PolygonWrapper& wrapper, Biome biome, int& id, Ref<ShaderMaterial> mat) = 0;
   virtual void configure_pentagon(PolygonWrapper& wrapper, Biome biome, int& id, Ref<ShaderMaterial> mat) = 0;
@@ -106,6 +148,21 @@ class Polyhedron : public Node3D {
   virtual void set_material_parameters(Ref<ShaderMaterial> mat) = 0;
   virtual void calculate_normals() = 0;
   void init();
+  /**
+   * @brief Schedules init() at the end of frame. Requests made before that result in single init()
+   */
+  void request_init();
+  void deferred_init();
+  /**
+   * @brief Replaces nodes of tiles by nodes of tiles built by generate() and uploads meshes. Called on the main thread
+   */
+  void publish();
+  /**
+   * @brief Queues call of setter with value while generation is running, since background thread reads properties
+   *
+   * @return whether setter should return without changing property
+   */
+  bool queue_if_generating(const char* setter, const Variant& value) { return _generation.queue_call(setter, value); }
 
   template <typename T>
   void process_ngons(std::vector<PolygonWrapper>& ngons, float min_z, float max_z);
@@ -117,6 +174,12 @@ class Polyhedron : public Node3D {
 
   int _divisions{1};
   int _patch_resolution{1};
+  int _chunk_size{0};
+  bool _analytic_picking{false};
+  bool _init_requested{false};
+  bool _init_postponed{false};
+  TilePicker _picker;
+  AsyncGeneration _generation;
   mutable std::map<int, std::set<int>> _neighbours_map;
 
   std::pair<std::vector<PolygonWrapper>, std::vector<PolygonWrapper>> calculate_shapes() const;
@@ -127,6 +190,25 @@ class Polyhedron : public Node3D {
                                                     std::map<Vector3i, PolygonWrapper>& polygons) const;
 
   void clear();
+  /**
+   * @brief Creates materials used by tiles. Called on the main thread before generate()
+   */
+  void init_materials();
+  /**
+   * @brief Builds tiles and their meshes from scratch. Runs on background thread during generate_async(), so it
+   * doesn't create nodes or upload meshes
+   */
+  void generate();
+
+  /**
+   * @brief Adds mesh instance drawing tile and uploads its mesh, used unless tiles are merged into chunks
+   */
+  void add_tile_instance(SotaMesh* mesh);
+  /**
+   * @brief Merges consecutive tiles into chunks of chunk_size tiles
+   */
+  void init_chunks();
+  std::optional<TilePick> pick(Vector3 origin, Vector3 direction) const;
 };
 
 }  // namespace sota
@@ -2,9 +2,11 @@
 
 #include <algorithm>  // for max, min
 #include <limits>     // for numeric_limits
+#include <vector>     // for vector
 
 #include "core/hex_mesh.h"                // for HexMeshParams
 #include "core/mesh.h"                    // for Orientation, Orient...
+#include "core/noise_cache.h"             // for NoiseCache
 #include "core/pent_mesh.h"               // for PentagonMeshParams
 #include "core/tile_mesh.h"               // for TileMesh
 #include "misc/types.h"                   // for ClipOptions, Biome
@@ -14,6 +16,7 @@
 #include "primitives/pentagon.h"          // for Pentagon
 #include "ridge_impl/plain_mesh.h"        // for PlainMesh
 #include "ridge_impl/ridge_mesh.h"        // for make_ridge_hex_mesh
+#include "tal/arrays.h"                   // for Vector3Array
 
 namespace sota {
 
@@ -27,16 +30,11 @@ void PolyhedronNoiseProcessor::configure_hexagon(PolygonWrapper& wrapper, Biome
                                        .clip_options = ClipOptions{},
                                        .tesselation_mode = TesselationMode::Recursive,
                                        .orientation = Orientation::Polyhedron},
-      .plain_noise = noise_polyhedron->_plain_noise,
-      .ridge_noise = nullptr,
   };
 
-  auto* mi = memnew(MeshInstance3D());
   auto& hex = *dynamic_cast<Hexagon*>(wrapper.polygon());
   Ref<PlainMesh> plain_mesh = make_ridge_hex_mesh<PlainMesh>(hex, params);
-  mi->set_mesh(plain_mesh->inner_mesh());
-
-  polyhedron.add_child(mi);
+  plain_mesh->build();
   wrapper.set_mesh(plain_mesh);
   ++id;
 }
@@ -50,16 +48,11 @@ void PolyhedronNoiseProcessor::configure_pentagon(PolygonWrapper& wrapper, Biome
                                                  .material = mat,
                                                  .tesselation_mode = TesselationMode::Recursive,
                                                  .orientation = Orientation::Polyhedron},
-      .plain_noise = noise_polyhedron->_plain_noise,
-      .ridge_noise = nullptr,
   };
 
-  auto* mi = memnew(MeshInstance3D());
   auto& pentagon = *dynamic_cast<Pentagon*>(wrapper.polygon());
   Ref<PlainMesh> plain_mesh = make_ridge_pentagon_mesh<PlainMesh>(pentagon, params);
-  mi->set_mesh(plain_mesh->inner_mesh());
-
-  polyhedron.add_child(mi);
+  plain_mesh->build();
   wrapper.set_mesh(plain_mesh);
   ++id;
 }
@@ -67,14 +60,25 @@ void PolyhedronNoiseProcessor::configure_pentagon(PolygonWrapper& wrapper, Biome
 void PolyhedronNoiseProcessor::process_meshes(Polyhedron& polyhedron, std::vector<Ref<TileMesh>>& meshes) {
   auto noise_polyhedron = dynamic_cast<NoisePolyhedron*>(&polyhedron);
 
+  // quarter of distance between neighbouring vertices of recursive tesselation
+  float approx_diameter = meshes[0]->inner_mesh()->get_R() * 2;
+  float noise_step = approx_diameter / 2 / (1 << (polyhedron._divisions - 1)) / 4;
+
+  std::vector<Vector3Array> points;
+  for (Ref<TileMesh>& mesh : meshes) {
+    points.push_back(dynamic_cast<PlainMesh*>(mesh.ptr())->initial_noise_points());
+  }
+  NoiseCache plain_noise;
+  plain_noise.reset(noise_polyhedron->_plain_noise, Orientation::Polyhedron, noise_step);
+  plain_noise.sample(points, 0);
+
   // initial heights calculation
   float global_min_y = std::numeric_limits<float>::max();
   float global_max_y = std::numeric_limits<float>::min();
   for (Ref<TileMesh>& mesh : meshes) {
     PlainMesh* plain_mesh = dynamic_cast<PlainMesh*>(mesh.ptr());
-    plain_mesh->calculate_initial_heights();
+    plain_mesh->calculate_initial_heights(plain_noise);
     plain_mesh->calculate_normals();
-    plain_mesh->update();
     auto [mesh_min_z, mesh_max_z] = plain_mesh->get_min_max_height();
     global_min_y = std::min(global_min_y, mesh_min_z);
     global_max_y = std::max(global_max_y, mesh_max_z);
@@ -90,10 +94,8 @@ void PolyhedronNoiseProcessor::process_meshes(Polyhedron& polyhedron, std::vecto
   // final heights calculation
   for (auto& mesh : meshes) {
     PlainMesh* plain_mesh = dynamic_cast<PlainMesh*>(mesh.ptr());
-    float approx_diameter = meshes[0]->inner_mesh()->get_R() * 2;
-    plain_mesh->calculate_final_heights(_distance_map, approx_diameter, polyhedron._divisions);
+    plain_mesh->calculate_final_heights(_distance_map, NoiseCache(), approx_diameter, polyhedron._divisions);
     plain_mesh->recalculate_all_except_vertices();
-    plain_mesh->update();
   }
 }
 
@@ -15,7 +15,6 @@
 #include "prism_impl/prism_pent_mesh.h"  // for PrismPentTile, Pris...
 #include "prism_polyhedron.h"            // for PrismPolyhedron
 #include "tal/material.h"                // for ShaderMaterial
-#include "tal/mesh.h"                    // for MeshInstance3D
 #include "tal/reference.h"               // for Ref
 
 namespace sota {
@@ -31,12 +30,8 @@ void PolyhedronPrismProcessor::configure_hexagon(PolygonWrapper& wrapper, Biome
                                                              .orientation = Orientation::Polyhedron},
                             .height = prism_polyhedron._prism_heights[biome]};
 
-  auto* mi = memnew(MeshInstance3D());
   auto& hex = *dynamic_cast<Hexagon*>(wrapper.polygon());
   Ref<PrismHexTile> prism_tile = Ref<PrismHexTile>(memnew(PrismHexTile(hex, params)));
-  mi->set_mesh(prism_tile->inner_mesh());
-
-  polyhedron.add_child(mi);
   wrapper.set_mesh(prism_tile);
   ++id;
 }
@@ -51,12 +46,8 @@ void PolyhedronPrismProcessor::configure_pentagon(PolygonWrapper& wrapper, Biome
                                                                     .orientation = Orientation::Polyhedron},
                              .height = prism_polyhedron._prism_heights[biome]};
 
-  auto* mi = memnew(MeshInstance3D());
   auto& pentagon = *dynamic_cast<Pentagon*>(wrapper.polygon());
   Ref<PrismPentTile> prism_tile = Ref<PrismPentTile>(memnew(PrismPentTile(pentagon, params)));
-  mi->set_mesh(prism_tile->inner_mesh());
-
-  polyhedron.add_child(mi);
   wrapper.set_mesh(prism_tile);
   ++id;
 }
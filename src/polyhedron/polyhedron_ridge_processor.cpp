@@ -10,13 +10,14 @@
 #include <unordered_set>  // for unordered_set
 #include <vector>         // for vector, vector<>::i...
 
-#include "core/hex_mesh.h"   // for HexMeshParams
-#include "core/mesh.h"       // for Orientation, Orient...
-#include "core/pent_mesh.h"  // for PentagonMeshParams
-#include "core/tile_mesh.h"  // for TileMesh
+#include "core/hex_mesh.h"     // for HexMeshParams
+#include "core/mesh.h"         // for Orientation, Orient...
+#include "core/noise_cache.h"  // for NoiseCache
+#include "core/pent_mesh.h"    // for PentagonMeshParams
+#include "core/tile_mesh.h"    // for TileMesh
 #include "misc/discretizer.h"
 #include "misc/types.h"                   // for Biome, ClipOptions
-#include "misc/utilities.h"               // for get_biome, create_h...
+#include "misc/utilities.h"               // for get_biome, is_water_mesh, is_mountain_mesh
 #include "polyhedron/hex_polyhedron.h"    // for Polyhedron
 #include "polyhedron/ridge_polyhedron.h"  // for RidgePolyhedron
 #include "primitives/hexagon.h"           // for Hexagon
@@ -25,6 +26,7 @@
 #include "ridge_impl/ridge_group.h"       // for RidgeGroup, GroupOf...
 #include "ridge_impl/ridge_mesh.h"        // for RidgeMesh, RidgeHex...
 #include "ridge_impl/ridge_set.h"         // for RidgeSet
+#include "tal/arrays.h"                   // for Vector3Array
 #include "tal/godot_core.h"               // for print, printerr
 #include "tal/reference.h"                // for Ref
 #include "tal/vector3.h"                  // for Vector3
@@ -51,16 +53,11 @@ void PolyhedronRidgeProcessor::configure_hexagon(PolygonWrapper& wrapper, Biome
                                        .clip_options = ClipOptions{},
                                        .tesselation_mode = TesselationMode::Recursive,
                                        .orientation = Orientation::Polyhedron},
-      .plain_noise = ridge_polyhedron._plain_noise,
-      .ridge_noise = ridge_polyhedron._ridge_noise,
   };
 
-  auto* mi = memnew(MeshInstance3D());
   auto& hex = *dynamic_cast<Hexagon*>(wrapper.polygon());
   Ref<RidgeMesh> ridge_mesh = create_ridge_mesh(biome, hex, params);
-  mi->set_mesh(ridge_mesh->inner_mesh());
-
-  polyhedron.add_child(mi);
+  ridge_mesh->build();
   wrapper.set_mesh(ridge_mesh);
   ++id;
 }
@@ -74,16 +71,11 @@ void PolyhedronRidgeProcessor::configure_pentagon(PolygonWrapper& wrapper, Biome
                                                  .material = mat,
                                                  .tesselation_mode = TesselationMode::Recursive,
                                                  .orientation = Orientation::Polyhedron},
-      .plain_noise = ridge_polyhedron._plain_noise,
-      .ridge_noise = ridge_polyhedron._ridge_noise,
   };
 
-  auto* mi = memnew(MeshInstance3D());
   auto& pentagon = *dynamic_cast<Pentagon*>(wrapper.polygon());
   Ref<RidgeMesh> ridge_mesh = create_ridge_mesh(biome, pentagon, params);
-  mi->set_mesh(ridge_mesh->inner_mesh());
-
-  polyhedron.add_child(mi);
+  ridge_mesh->build();
   wrapper.set_mesh(ridge_mesh);
   ++id;
 }
@@ -210,14 +202,25 @@ void PolyhedronRidgeProcessor::process_meshes() {
     group.init_ridges(_distance_map, _ridge_config.bottom_ridge_offset, _ridge_polyhedron._divisions);
   }
 
+  // quarter of distance between neighbouring vertices of recursive tesselation
+  float approx_diameter = _meshes_wrapped[0]->mesh()->inner_mesh()->get_R() * 2;
+  float noise_step = approx_diameter / 2 / (1 << (_ridge_polyhedron._divisions - 1)) / 4;
+
+  std::vector<Vector3Array> initial_points;
+  for (PolygonWrapper* wrapper : _meshes_wrapped) {
+    initial_points.push_back(dynamic_cast<RidgeMesh*>(wrapper->mesh().ptr())->initial_noise_points());
+  }
+  NoiseCache plain_noise;
+  plain_noise.reset(_ridge_polyhedron._plain_noise, Orientation::Polyhedron, noise_step);
+  plain_noise.sample(initial_points, 0);
+
   // initial heights calculation
   float global_min_y = std::numeric_limits<float>::max();
   float global_max_y = std::numeric_limits<float>::min();
   for (PolygonWrapper* wrapper : _meshes_wrapped) {
     RidgeMesh* ridge_mesh = dynamic_cast<RidgeMesh*>(wrapper->mesh().ptr());
-    ridge_mesh->calculate_initial_heights();
+    ridge_mesh->calculate_initial_heights(plain_noise);
     ridge_mesh->calculate_normals();
-    ridge_mesh->update();
     auto [mesh_min_z, mesh_max_z] = ridge_mesh->get_min_max_height();
     global_min_y = std::min(global_min_y, mesh_min_z);
     global_max_y = std::max(global_max_y, mesh_max_z);
@@ -230,14 +233,23 @@ void PolyhedronRidgeProcessor::process_meshes() {
     ridge_mesh->set_shift_compress(-global_min_y, compress);
   }
 
-  // final heights calculation
+  // only ridge based heights use noise
+  std::vector<Vector3Array> final_points;
   for (PolygonWrapper* wrapper : _meshes_wrapped) {
     RidgeMesh* ridge_mesh = dynamic_cast<RidgeMesh*>(wrapper->mesh().ptr());
+    if (is_water_mesh(ridge_mesh) || is_mountain_mesh(ridge_mesh)) {
+      final_points.push_back(ridge_mesh->final_noise_points());
+    }
+  }
+  NoiseCache ridge_noise;
+  ridge_noise.reset(_ridge_polyhedron._ridge_noise, Orientation::Polyhedron, noise_step);
+  ridge_noise.sample(final_points, 0);
 
-    float approx_diameter = _meshes_wrapped[0]->mesh()->inner_mesh()->get_R() * 2;
-    ridge_mesh->calculate_final_heights(_distance_map, approx_diameter, _ridge_polyhedron._divisions);
+  // final heights calculation
+  for (PolygonWrapper* wrapper : _meshes_wrapped) {
+    RidgeMesh* ridge_mesh = dynamic_cast<RidgeMesh*>(wrapper->mesh().ptr());
+    ridge_mesh->calculate_final_heights(_distance_map, ridge_noise, approx_diameter, _ridge_polyhedron._divisions);
     ridge_mesh->recalculate_all_except_vertices();
-    ridge_mesh->update();
   }
 }
 
@@ -27,23 +27,35 @@ void PrismPolyhedron::_bind_methods() {
 
 // Heights
 void PrismPolyhedron::set_plain_height(const float p_height) {
+  if (queue_if_generating("set_plain_height", p_height)) {
+    return;
+  }
   _prism_heights[Biome::PLAIN] = p_height;
-  init();
+  request_init();
 }
 
 void PrismPolyhedron::set_hill_height(const float p_height) {
+  if (queue_if_generating("set_hill_height", p_height)) {
+    return;
+  }
   _prism_heights[Biome::HILL] = p_height;
-  init();
+  request_init();
 }
 
 void PrismPolyhedron::set_water_height(const float p_height) {
+  if (queue_if_generating("set_water_height", p_height)) {
+    return;
+  }
   _prism_heights[Biome::WATER] = p_height;
-  init();
+  request_init();
 }
 
 void PrismPolyhedron::set_mountain_height(const float p_height) {
+  if (queue_if_generating("set_mountain_height", p_height)) {
+    return;
+  }
   _prism_heights[Biome::MOUNTAIN] = p_height;
-  init();
+  request_init();
 }
 
 float PrismPolyhedron::get_plain_height() const { return _prism_heights.find(Biome::PLAIN)->second; }
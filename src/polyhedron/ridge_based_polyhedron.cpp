@@ -4,6 +4,7 @@
 #include <iterator>
 #include <vector>
 
+#include "core/godot_utils.h"  // for reconnect_changed
 #include "core/smooth_shades_processor.h"
 #include "core/tile_mesh.h"
 #include "misc/discretizer.h"
@@ -37,28 +38,41 @@ void RidgeBasedPolyhedron::_bind_methods() {
 }
 
 void RidgeBasedPolyhedron::set_smooth_normals(const bool p_smooth_normals) {
+  if (queue_if_generating("set_smooth_normals", p_smooth_normals)) {
+    return;
+  }
   _smooth_normals = p_smooth_normals;
   calculate_normals();
+  publish();
 }
 
 void RidgeBasedPolyhedron::set_compression_factor(const float p_compression_factor) {
+  if (queue_if_generating("set_compression_factor", p_compression_factor)) {
+    return;
+  }
   _compression_factor = p_compression_factor;
-  init();
+  request_init();
 }
 
 void RidgeBasedPolyhedron::set_plain_noise(const Ref<FastNoiseLite> p_noise) {
+  if (queue_if_generating("set_plain_noise", p_noise)) {
+    return;
+  }
+  reconnect_changed(_plain_noise.ptr(), p_noise.ptr(), Callable(this, "request_init"));
   _plain_noise = p_noise;
   if (_plain_noise.ptr()) {
-    _plain_noise->connect("changed", Callable(this, "init"));
-    init();
+    request_init();
   }
 }
 
 void RidgeBasedPolyhedron::set_ridge_noise(const Ref<FastNoiseLite> p_noise) {
+  if (queue_if_generating("set_ridge_noise", p_noise)) {
+    return;
+  }
+  reconnect_changed(_ridge_noise.ptr(), p_noise.ptr(), Callable(this, "request_init"));
   _ridge_noise = p_noise;
   if (_ridge_noise.ptr()) {
-    _ridge_noise->connect("changed", Callable(this, "init"));
-    init();
+    request_init();
   }
 }
 
@@ -19,18 +19,27 @@ void RidgePolyhedron::_bind_methods() {
 }
 
 void RidgePolyhedron::set_ridge_top_offset(float p_ridge_top_offset) {
+  if (queue_if_generating("set_ridge_top_offset", p_ridge_top_offset)) {
+    return;
+  }
   _ridge_processor.set_top_offset(p_ridge_top_offset);
-  init();
+  request_init();
 }
 
 void RidgePolyhedron::set_ridge_bottom_offset(float p_ridge_bottom_offset) {
+  if (queue_if_generating("set_ridge_bottom_offset", p_ridge_bottom_offset)) {
+    return;
+  }
   _ridge_processor.set_bottom_offset(p_ridge_bottom_offset);
-  init();
+  request_init();
 }
 
 void RidgePolyhedron::set_biomes_hill_level_ratio(float p_biomes_hill_level_ratio) {
+  if (queue_if_generating("set_biomes_hill_level_ratio", p_biomes_hill_level_ratio)) {
+    return;
+  }
   _biomes_hill_level_ratio = p_biomes_hill_level_ratio;
-  init();
+  request_init();
 }
 
 float RidgePolyhedron::get_ridge_top_offset() const { return _ridge_processor.get_top_offset(); }
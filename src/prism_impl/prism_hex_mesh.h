@@ -46,7 +46,8 @@ class PrismHexTile : public TileMesh {
   HexMesh* inner_mesh() const override { return _prism_hex_mesh.ptr(); }
   PrismHexTile(Hexagon hex, PrismHexMeshParams params)
       : _prism_hex_mesh(Ref<PrismHexMesh>(memnew(PrismHexMesh(hex, params)))) {
-    _prism_hex_mesh->init();
+    // uploaded by owner on the main thread
+    _prism_hex_mesh->build();
   }
 
  protected:
@@ -45,7 +45,8 @@ class PrismPentTile : public TileMesh {
   PentMesh* inner_mesh() const override { return _prism_pent_mesh.ptr(); }
   PrismPentTile(Pentagon pentagon, PrismPentMeshParams params)
       : _prism_pent_mesh(Ref<PrismPentMesh>(memnew(PrismPentMesh(pentagon, params)))) {
-    _prism_pent_mesh->init();
+    // uploaded by owner on the main thread
+    _prism_pent_mesh->build();
   }
 
  protected:
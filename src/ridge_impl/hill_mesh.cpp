@@ -1,6 +1,7 @@
 #include "hill_mesh.h"
 
 #include <memory>  // for unique_ptr
+#include <span>    // for span
 
 #include "core/general_utility.h"  // for MeshProcessor
 #include "core/mesh.h"             // for SotaMesh
@@ -10,13 +11,16 @@
 
 namespace sota {
 
-void HillMesh::calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) {
+void HillMesh::calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                                       float diameter, int divisions) {
   shift_compress();
 
-  // TODO add piping for inputs/outputs
-  auto vertices = _mesh->get_vertices();
-  _processor->calculate_hill_heights(vertices, _mesh->get_r(), _mesh->get_R(), _mesh->get_center());
-  _mesh->set_vertices(vertices);
+  float r = _mesh->get_r();
+  float R = _mesh->get_R();
+  Vector3 center = _mesh->get_center();
+  _mesh->edit_vertices([this, r, R, center](std::span<Vector3> vertices) {
+    _processor->calculate_hill_heights(vertices, r, R, center);
+  });
 
   _min_height += _y_shift;
   _min_height *= _y_compress;
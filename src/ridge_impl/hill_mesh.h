@@ -13,7 +13,8 @@ class HillMesh : public RidgeMesh {
  public:
   HillMesh(Hexagon hex, RidgeHexMeshParams params) : RidgeMesh(hex, params) {}
   HillMesh(Pentagon pentagon, RidgePentagonMeshParams params) : RidgeMesh(pentagon, params) {}
-  void calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) override;
+  void calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                               float diameter, int divisions) override;
 };
 
 }  // namespace sota
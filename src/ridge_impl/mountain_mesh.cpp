@@ -7,9 +7,10 @@ namespace sota {
 // TODO globals
 constexpr float top_y_offset = 0.5;
 
-void MountainMesh::calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) {
+void MountainMesh::calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                                           float diameter, int divisions) {
   calculate_ridge_based_heights([](double a, double b, double c) { return std::lerp(a, b, c); }, top_y_offset,
-                                distance_map, divisions);
+                                distance_map, ridge_noise, divisions);
 }
 
 }  // namespace sota
@@ -6,7 +6,8 @@
 
 namespace sota {
 
-void PlainMesh::calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) {
+void PlainMesh::calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                                        float diameter, int divisions) {
   shift_compress();
   _min_height += _y_shift;
   _min_height *= _y_compress;
@@ -14,7 +14,8 @@ class PlainMesh : public RidgeMesh {
  public:
   PlainMesh(Hexagon hex, RidgeHexMeshParams params) : RidgeMesh(hex, params) {}
   PlainMesh(Pentagon pentagon, RidgePentagonMeshParams params) : RidgeMesh(pentagon, params) {}
-  void calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) override;
+  void calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                               float diameter, int divisions) override;
 };
 
 }  // namespace sota
@@ -1,14 +1,23 @@
 #include "ridge.h"
 
-#include "tal/vector3.h"
+#include <algorithm>  // for clamp
+
+#include "tal/vector3.h"  // for Vector3
 
 namespace sota {
 
 Ridge::Ridge(Vector3 start, Vector3 end) : _start(start), _end(end) {}
 
-void Ridge::set_points(std::vector<Vector3> points) { _points = points; }
-
-const std::vector<Vector3> Ridge::get_points() const { return _points; }
+Vector3 Ridge::closest_point(Vector3 p, bool flat) const {
+  Vector3 direction = _end - _start;
+  Vector3 to_p = p - _start;
+  if (flat) {
+    direction.y = 0;
+    to_p.y = 0;
+  }
+  float length_squared = direction.length_squared();
+  float t = length_squared > 0 ? std::clamp(to_p.dot(direction) / length_squared, 0.0f, 1.0f) : 0.0f;
+  return _start + (_end - _start) * t;
+}
 
 }  // namespace sota
-
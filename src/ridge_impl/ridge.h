@@ -1,12 +1,13 @@
 #pragma once
 
-#include <vector>  // for vector
-
 #include "misc/types.h"
 #include "tal/vector3.h"  // for Vector3
 
 namespace sota {
 
+/**
+ * @brief Straight piece of ridge line. Consecutive pieces of connection form polyline
+ */
 class Ridge {
  public:
   Ridge(Vector3 start, Vector3 end);
@@ -15,13 +16,16 @@ class Ridge {
   Ridge& operator=(const Ridge& other) = default;
   Ridge& operator=(Ridge&& other) = default;
 
-  void set_points(std::vector<Vector3> points);
-  const std::vector<Vector3> get_points() const;
   Vector3 start() const { return _start; }
   Vector3 end() const { return _end; }
 
+  /**
+   * @brief Point of ridge closest to p. If flat, projection is done in xz plane and height of point is interpolated
+   * between heights of start and end
+   */
+  Vector3 closest_point(Vector3 p, bool flat) const;
+
  private:
-  std::vector<Vector3> _points;
   Vector3 _start;
   Vector3 _end;
 };
@@ -2,9 +2,13 @@
 
 #include <algorithm>  // for transform
 #include <iterator>   // for back_insert_iterator, back_inserter
+#include <memory>     // for make_shared
 
-#include "ridge_impl/ridge_mesh.h"  // for RidgeMesh
-#include "ridge_impl/ridge_set.h"   // for RidgeSet
+#include "core/mesh.h"                // for SotaMesh, Orientation
+#include "ridge_impl/ridge_config.h"  // for RidgeConfig
+#include "ridge_impl/ridge_index.h"   // for RidgeIndex
+#include "ridge_impl/ridge_mesh.h"    // for RidgeMesh
+#include "ridge_impl/ridge_set.h"     // for RidgeSet
 #include "vector3i.h"
 
 namespace sota {
@@ -15,7 +19,7 @@ void RidgeGroup::init_ridges(DiscreteVertexToDistance& distance_map, float offse
     return;
   }
   if (_meshes.size() > 1) {
-    _ridge_set.value()->create_dfs_random(_meshes, offset, divisions);
+    _ridge_set.value()->create_dfs_random(_meshes, offset);
   } else {
     _ridge_set.value()->create_single(_meshes[0], offset);
   }
@@ -24,6 +28,20 @@ void RidgeGroup::init_ridges(DiscreteVertexToDistance& distance_map, float offse
   calculate_corner_points_distances_to_border(distance_map, divisions);
 }
 
+void RidgeGroup::init_local_ridges(float offset) {
+  if (!_ridge_set) {
+    return;
+  }
+  _ridge_set.value()->create_local(_meshes, offset);
+  assign_ridges();
+}
+
+void RidgeGroup::set_ridge_config(RidgeConfig config) {
+  if (_ridge_set) {
+    _ridge_set.value()->set_config(config);
+  }
+}
+
 const GroupOfRidgeMeshes& RidgeGroup::meshes() { return _meshes; }
 
 void RidgeGroup::fmap(std::function<void(const GroupOfRidgeMeshes&)> func) { func(_meshes); }
@@ -34,8 +52,12 @@ void RidgeGroup::assign_ridges() {
   std::transform(ridges->begin(), ridges->end(), std::back_inserter(ridge_pointers),
                  [](Ridge& ridge) { return &ridge; });
 
-  for (auto* mesh : _meshes) {
-    mesh->set_ridges(ridge_pointers);
+  // meshes of group look up ridges near them in one index of group
+  SotaMesh* mesh = _meshes[0]->inner_mesh();
+  auto index =
+      std::make_shared<const RidgeIndex>(ridge_pointers, mesh->get_R(), mesh->get_orientation() == Orientation::Plane);
+  for (auto* m : _meshes) {
+    m->set_ridges(index);
   }
 }
 
@@ -33,6 +33,12 @@ class RidgeGroup {
 
   void fmap(std::function<void(const GroupOfRidgeMeshes&)> func);
   void init_ridges(DiscreteVertexToDistance& distance_map, float offset, int divisions);
+  /**
+   * @brief Ridges which depend only on the neighbourhood of every tile, see RidgeSet::create_local(). Distances to
+   * border are not calculated
+   */
+  void init_local_ridges(float offset);
+  void set_ridge_config(RidgeConfig config);
 
  private:
   GroupOfRidgeMeshes _meshes;
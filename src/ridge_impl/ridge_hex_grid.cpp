@@ -1,37 +1,44 @@
 #include "ridge_hex_grid.h"
 
-#include <algorithm>      // for find, max, min
-#include <functional>     // for reference_wrapper
+#include <algorithm>      // for max, min, clamp
+#include <array>          // for array
 #include <limits>         // for numeric_limits
 #include <memory>         // for make_unique, alloca...
 #include <unordered_map>  // for unordered_map, unor...
+#include <vector>         // for vector
 
 #include "algo/dsu.h"                  // for DSU
 #include "core/general_utility.h"      // for GeneralUtility
-#include "core/godot_utils.h"          // for clean_children
+#include "core/godot_utils.h"          // for reconnect_changed
 #include "core/hex_grid.h"             // for TilesLayout
 #include "core/hex_mesh.h"             // for HexMeshParams
 #include "core/hexagonal_utility.h"    // for HexagonalUtility
-#include "core/mesh.h"                 // for SotaMesh
+#include "core/mesh.h"                 // for SotaMesh, Orientation
+#include "core/noise_cache.h"          // for NoiseCache
+#include "core/parallel.h"             // for parallel_for
+#include "core/planar_decimator.h"     // for DecimationStats
 #include "core/rectangular_utility.h"  // for RectangularUtility
 #include "core/smooth_shades_processor.h"
 #include "core/tile_mesh.h"           // for TileMesh
 #include "core/utils.h"               // for is_odd, pointy_top_...
 #include "misc/biome_calculator.h"    // for BiomeCalculator
-#include "misc/cube_coordinates.h"    // for CubeCoordinates
+#include "misc/cube_coordinates.h"    // for OffsetCoordinates, pixelToCube
+#include "misc/discretizer.h"         // for VertexToNormalDiscretizer
 #include "misc/tile.h"                // for BiomeTile, Tile
 #include "misc/types.h"               // for Biome, GroupedMeshV...
-#include "misc/utilities.h"           // for create_ridge_mesh
+#include "misc/utilities.h"           // for create_ridge_mesh, is_water_mesh
 #include "primitives/hexagon.h"       // for make_hexagon_at_pos...
 #include "ridge_impl/ridge_config.h"  // for RidgeConfig
 #include "ridge_impl/ridge_group.h"   // for RidgeGroup, GroupOf...
 #include "ridge_impl/ridge_mesh.h"    // for RidgeMesh, RidgeHex...
 #include "ridge_impl/ridge_set.h"     // for RidgeSet
+#include "tal/arrays.h"               // for Dictionary
 #include "tal/callable.h"             // for Callable
 #include "tal/godot_core.h"           // for D_METHOD, ClassDB
 #include "tal/material.h"             // for ShaderMaterial
 #include "tal/noise.h"                // for FastNoiseLite
 #include "tal/texture.h"              // for Texture
+#include "tal/vector2.h"              // for Vector2
 #include "tal/vector3.h"              // for Vector3
 #include "tal/vector3i.h"             // for Vector3i
 
@@ -44,21 +51,145 @@ RidgeHexGrid::RidgeHexGrid() {
   _texture[Biome::MOUNTAIN] = Ref<Texture>();
 }
 
-void RidgeHexGrid::init() {
-  init_col_row_layout();
-  if (_col_row_layout.empty()) {
+void RidgeHexGrid::init() { regenerate(STAGE_TILES); }
+
+int RidgeHexGrid::with_dependent_stages(int stages) {
+  if (stages & STAGE_TILES) {
+    // new materials are configured on creation
+    stages |= STAGE_MOUNTAIN_RIDGES | STAGE_WATER_RIDGES | STAGE_HEIGHTS;
+  }
+  if (stages & STAGE_MOUNTAIN_RIDGES) {
+    stages |= STAGE_MOUNTAIN_HEIGHTS;
+  }
+  if (stages & STAGE_WATER_RIDGES) {
+    stages |= STAGE_WATER_HEIGHTS;
+  }
+  if (stages & (STAGE_MOUNTAIN_HEIGHTS | STAGE_WATER_HEIGHTS | STAGE_HEIGHTS)) {
+    stages |= STAGE_NORMALS;
+  }
+  return stages;
+}
+
+void RidgeHexGrid::regenerate(int p_stages) {
+  _dirty |= with_dependent_stages(p_stages);
+  if (!_regeneration_scheduled) {
+    _regeneration_scheduled = true;
+    call_deferred("regenerate_dirty");
+  }
+}
+
+void RidgeHexGrid::regenerate_dirty() {
+  _regeneration_scheduled = false;
+  if (!_dirty || is_generating()) {
+    // stages invalidated during generation are run by finish_generation()
     return;
   }
-  init_hexmesh();
+  int stages = _dirty;
+  _dirty = 0;
+  if (stages & STAGE_TILES) {
+    init_materials();
+    allow_reuse(true);
+  }
+  regenerate_stages(stages);
+  if (stages & STAGE_NORMALS) {
+    publish();
+  }
+}
 
-  assign_cube_coordinates_map();
-  init_biomes();
+void RidgeHexGrid::init_materials() {
+  _materials.clear();
+  for (Biome biome : {Biome::PLAIN, Biome::HILL, Biome::MOUNTAIN, Biome::WATER}) {
+    _materials.get(_shader, static_cast<int>(biome),
+                   [this, biome](Ref<ShaderMaterial> material) { configure_material(biome, material); });
+  }
+}
 
-  // print_biomes();
+void RidgeHexGrid::generate() { regenerate_stages(with_dependent_stages(STAGE_TILES)); }
 
-  prepare_heights_calculation();
-  calculate_final_heights();
-  calculate_normals();
+void RidgeHexGrid::generate_async() {
+  if (!is_generating()) {
+    // all stages are run by generation
+    _dirty = 0;
+  }
+  HexGrid::generate_async();
+}
+
+void RidgeHexGrid::finish_generation() {
+  HexGrid::finish_generation();
+  if (_dirty) {
+    regenerate(_dirty);
+  }
+}
+
+void RidgeHexGrid::regenerate_stages(int stages) {
+  if (stages & STAGE_TILES) {
+    init_col_row_layout();
+    if (_col_row_layout.empty()) {
+      return;
+    }
+    init_hexmesh();
+    index_tiles();
+    init_biomes();
+    init_neighbours();
+    report_progress(0.3);
+    if (is_cancelled()) {
+      return;
+    }
+  } else if (stages & STAGE_MATERIALS) {
+    _materials.reconfigure([this](int variant, Ref<ShaderMaterial> material) {
+      configure_material(static_cast<Biome>(variant), material);
+    });
+  }
+
+  std::vector<RidgeMesh*> meshes = height_meshes(stages);
+  if (!meshes.empty() && !(stages & STAGE_TILES)) {
+    parallel_for(meshes.size(), _threads, [&meshes](int i) { meshes[i]->build(); });
+  }
+
+  if (stages & STAGE_MOUNTAIN_RIDGES) {
+    init_ridges(_mountain_groups, _ridge_config.top_ridge_offset);
+  }
+  if (stages & STAGE_WATER_RIDGES) {
+    init_ridges(_water_groups, _ridge_config.bottom_ridge_offset);
+  }
+  report_progress(0.5);
+  if (is_cancelled()) {
+    return;
+  }
+  if (!meshes.empty()) {
+    calculate_initial_heights(meshes, stages & STAGE_HEIGHTS);
+    calculate_final_heights(meshes);
+  }
+  report_progress(0.8);
+  if (is_cancelled()) {
+    return;
+  }
+
+  if (stages & STAGE_NORMALS) {
+    calculate_normals();
+    finalize_tiles();
+    calculate_lods();
+  }
+}
+
+std::vector<RidgeMesh*> RidgeHexGrid::height_meshes(int stages) {
+  std::vector<RidgeMesh*> result;
+  auto append = [&result](std::vector<RidgeGroup>& groups) {
+    for (RidgeGroup& group : groups) {
+      result.insert(result.end(), group.meshes().begin(), group.meshes().end());
+    }
+  };
+  if (stages & (STAGE_HEIGHTS | STAGE_MOUNTAIN_HEIGHTS)) {
+    append(_mountain_groups);
+  }
+  if (stages & (STAGE_HEIGHTS | STAGE_WATER_HEIGHTS)) {
+    append(_water_groups);
+  }
+  if (stages & STAGE_HEIGHTS) {
+    append(_plain_groups);
+    append(_hill_groups);
+  }
+  return result;
 }
 
 void RidgeHexGrid::_bind_methods() {
@@ -66,6 +197,24 @@ void RidgeHexGrid::_bind_methods() {
   ClassDB::bind_method(D_METHOD("set_smooth_normals", "p_smooth_normals"), &RidgeHexGrid::set_smooth_normals);
   ADD_PROPERTY(PropertyInfo(Variant::BOOL, "_smooth_normals"), "set_smooth_normals", "get_smooth_normals");
 
+  ClassDB::bind_method(D_METHOD("get_decimation_tolerance"), &RidgeHexGrid::get_decimation_tolerance);
+  ClassDB::bind_method(D_METHOD("set_decimation_tolerance", "p_decimation_tolerance"),
+                       &RidgeHexGrid::set_decimation_tolerance);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "decimation_tolerance"), "set_decimation_tolerance",
+               "get_decimation_tolerance");
+
+  ClassDB::bind_method(D_METHOD("get_decimation_stats"), &RidgeHexGrid::get_decimation_stats);
+
+  ClassDB::bind_method(D_METHOD("get_threads"), &RidgeHexGrid::get_threads);
+  ClassDB::bind_method(D_METHOD("set_threads", "p_threads"), &RidgeHexGrid::set_threads);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "threads"), "set_threads", "get_threads");
+
+  ClassDB::bind_method(D_METHOD("regenerate", "p_stages"), &RidgeHexGrid::regenerate);
+  ClassDB::bind_method(D_METHOD("regenerate_dirty"), &RidgeHexGrid::regenerate_dirty);
+  ClassDB::bind_method(D_METHOD("on_biomes_noise_changed"), &RidgeHexGrid::on_biomes_noise_changed);
+  ClassDB::bind_method(D_METHOD("on_plain_noise_changed"), &RidgeHexGrid::on_plain_noise_changed);
+  ClassDB::bind_method(D_METHOD("on_ridge_noise_changed"), &RidgeHexGrid::on_ridge_noise_changed);
+
   ADD_GROUP("Ridge params", "ridge_");
   ClassDB::bind_method(D_METHOD("get_ridge_variation_min_bound"), &RidgeHexGrid::get_ridge_variation_min_bound);
   ClassDB::bind_method(D_METHOD("set_ridge_variation_min_bound", "p_ridge_variation_min_bound"),
@@ -97,6 +246,11 @@ void RidgeHexGrid::_bind_methods() {
                        &RidgeHexGrid::set_biomes_plain_hill_gain);
   ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "biomes_plain_hill_gain"), "set_biomes_plain_hill_gain",
                "get_biomes_plain_hill_gain");
+  ClassDB::bind_method(D_METHOD("get_biomes_seamless_range"), &RidgeHexGrid::get_biomes_seamless_range);
+  ClassDB::bind_method(D_METHOD("set_biomes_seamless_range", "p_biomes_seamless_range"),
+                       &RidgeHexGrid::set_biomes_seamless_range);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "biomes_seamless_range", PROPERTY_HINT_RANGE, "0.05,1,0.01"),
+               "set_biomes_seamless_range", "get_biomes_seamless_range");
 
   ADD_GROUP("Noise", "noise_");
   ClassDB::bind_method(D_METHOD("get_biomes_noise"), &RidgeHexGrid::get_biomes_noise);
@@ -137,85 +291,188 @@ void RidgeHexGrid::_bind_methods() {
 }
 
 void RidgeHexGrid::set_smooth_normals(const bool p_smooth_normals) {
+  if (queue_if_generating("set_smooth_normals", p_smooth_normals)) {
+    return;
+  }
   _smooth_normals = p_smooth_normals;
-  calculate_normals();
+  regenerate(STAGE_NORMALS);
+}
+
+void RidgeHexGrid::set_decimation_tolerance(const float p_decimation_tolerance) {
+  if (queue_if_generating("set_decimation_tolerance", p_decimation_tolerance)) {
+    return;
+  }
+  _decimation_tolerance = p_decimation_tolerance > 0 ? p_decimation_tolerance : 0;
+  regenerate(STAGE_HEIGHTS);
+}
+
+void RidgeHexGrid::set_threads(const int p_threads) {
+  if (queue_if_generating("set_threads", p_threads)) {
+    return;
+  }
+  // result doesn't depend on number of threads, so nothing is regenerated
+  _threads = p_threads > 0 ? p_threads : 0;
 }
 
 void RidgeHexGrid::set_ridge_variation_min_bound(const float p_ridge_variation_min_bound) {
+  if (queue_if_generating("set_ridge_variation_min_bound", p_ridge_variation_min_bound)) {
+    return;
+  }
   _ridge_config.variation_min_bound = p_ridge_variation_min_bound;
-  init();
+  regenerate(STAGE_MOUNTAIN_RIDGES | STAGE_WATER_RIDGES);
 }
 
 void RidgeHexGrid::set_ridge_variation_max_bound(const float p_ridge_variation_max_bound) {
+  if (queue_if_generating("set_ridge_variation_max_bound", p_ridge_variation_max_bound)) {
+    return;
+  }
   _ridge_config.variation_max_bound = p_ridge_variation_max_bound;
-  init();
+  regenerate(STAGE_MOUNTAIN_RIDGES | STAGE_WATER_RIDGES);
 }
 
 void RidgeHexGrid::set_ridge_top_offset(float p_ridge_top_offset) {
+  if (queue_if_generating("set_ridge_top_offset", p_ridge_top_offset)) {
+    return;
+  }
   _ridge_config.top_ridge_offset = p_ridge_top_offset;
-  init();
+  // offset is shader parameter as well
+  regenerate(STAGE_MOUNTAIN_RIDGES | STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_ridge_bottom_offset(float p_ridge_bottom_offset) {
+  if (queue_if_generating("set_ridge_bottom_offset", p_ridge_bottom_offset)) {
+    return;
+  }
   _ridge_config.bottom_ridge_offset = p_ridge_bottom_offset;
-  init();
+  regenerate(STAGE_WATER_RIDGES | STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_biomes_hill_level_ratio(float p_biomes_hill_level_ratio) {
+  if (queue_if_generating("set_biomes_hill_level_ratio", p_biomes_hill_level_ratio)) {
+    return;
+  }
   _biomes_hill_level_ratio = p_biomes_hill_level_ratio;
-  init();
+  regenerate(STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_biomes_plain_hill_gain(float p_biomes_plain_hill_gain) {
+  if (queue_if_generating("set_biomes_plain_hill_gain", p_biomes_plain_hill_gain)) {
+    return;
+  }
   _biomes_plain_hill_gain = p_biomes_plain_hill_gain;
-  init();
+  regenerate(STAGE_HEIGHTS);
+}
+
+void RidgeHexGrid::set_biomes_seamless_range(float p_biomes_seamless_range) {
+  if (queue_if_generating("set_biomes_seamless_range", p_biomes_seamless_range)) {
+    return;
+  }
+  _biomes_seamless_range = std::max(p_biomes_seamless_range, 0.05f);
+  if (_seamless) {
+    regenerate(STAGE_TILES);
+  }
 }
 
 void RidgeHexGrid::set_biomes_noise(const Ref<FastNoiseLite> p_biomes_noise) {
+  if (queue_if_generating("set_biomes_noise", p_biomes_noise)) {
+    return;
+  }
+  reconnect_changed(_biomes_noise.ptr(), p_biomes_noise.ptr(), Callable(this, "on_biomes_noise_changed"));
   _biomes_noise = p_biomes_noise;
   if (_biomes_noise.ptr()) {
-    _biomes_noise->connect("changed", Callable(this, "init"));
-    init();
+    regenerate(STAGE_TILES);
   }
 }
 
 void RidgeHexGrid::set_hex_noise(const Ref<FastNoiseLite> p_hex_noise) {
+  if (queue_if_generating("set_hex_noise", p_hex_noise)) {
+    return;
+  }
+  reconnect_changed(_plain_noise.ptr(), p_hex_noise.ptr(), Callable(this, "on_plain_noise_changed"));
   _plain_noise = p_hex_noise;
   if (_plain_noise.ptr()) {
-    _plain_noise->connect("changed", Callable(this, "init"));
-    init();
+    regenerate(STAGE_HEIGHTS);
   }
 }
 
 void RidgeHexGrid::set_ridge_noise(const Ref<FastNoiseLite> p_ridge_noise) {
+  if (queue_if_generating("set_ridge_noise", p_ridge_noise)) {
+    return;
+  }
+  reconnect_changed(_ridge_noise.ptr(), p_ridge_noise.ptr(), Callable(this, "on_ridge_noise_changed"));
   _ridge_noise = p_ridge_noise;
   if (_ridge_noise.ptr()) {
-    _ridge_noise->connect("changed", Callable(this, "init"));
-    init();
+    regenerate(STAGE_MOUNTAIN_HEIGHTS | STAGE_WATER_HEIGHTS);
   }
 }
 
+void RidgeHexGrid::on_biomes_noise_changed() { regenerate(STAGE_TILES); }
+void RidgeHexGrid::on_plain_noise_changed() { regenerate(STAGE_HEIGHTS); }
+void RidgeHexGrid::on_ridge_noise_changed() { regenerate(STAGE_MOUNTAIN_HEIGHTS | STAGE_WATER_HEIGHTS); }
+
 void RidgeHexGrid::set_plain_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_plain_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::PLAIN] = p_texture;
-  init();
+  regenerate(STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_hill_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_hill_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::HILL] = p_texture;
-  init();
+  regenerate(STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_water_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_water_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::WATER] = p_texture;
-  init();
+  regenerate(STAGE_MATERIALS);
 }
 
 void RidgeHexGrid::set_mountain_texture(const Ref<Texture> p_texture) {
+  if (queue_if_generating("set_mountain_texture", p_texture)) {
+    return;
+  }
   _texture[Biome::MOUNTAIN] = p_texture;
-  init();
+  regenerate(STAGE_MATERIALS);
+}
+
+void RidgeHexGrid::copy_settings(const RidgeHexGrid& other) {
+  _diameter = other._diameter;
+  _divisions = other._divisions;
+  _shader = other._shader;
+  _frame_state = other._frame_state;
+  _frame_offset = other._frame_offset;
+  _indexed = other._indexed;
+  _mesh_attributes = other._mesh_attributes;
+  _direct_upload = other._direct_upload;
+  _lod_levels = other._lod_levels;
+  _lod_distance = other._lod_distance;
+  _chunk_size = other._chunk_size;
+  _analytic_picking = other._analytic_picking;
+  set_process_unhandled_input(_analytic_picking);
+
+  _texture = other._texture;
+  _biomes_noise = other._biomes_noise;
+  _plain_noise = other._plain_noise;
+  _ridge_noise = other._ridge_noise;
+  _smooth_normals = other._smooth_normals;
+  _decimation_tolerance = other._decimation_tolerance;
+  _threads = other._threads;
+  _biomes_hill_level_ratio = other._biomes_hill_level_ratio;
+  _biomes_plain_hill_gain = other._biomes_plain_hill_gain;
+  _biomes_seamless_range = other._biomes_seamless_range;
+  _ridge_config = other._ridge_config;
 }
 
 bool RidgeHexGrid::get_smooth_normals() const { return _smooth_normals; }
+float RidgeHexGrid::get_decimation_tolerance() const { return _decimation_tolerance; }
+int RidgeHexGrid::get_threads() const { return _threads; }
 Ref<FastNoiseLite> RidgeHexGrid::get_biomes_noise() const { return _biomes_noise; }
 Ref<FastNoiseLite> RidgeHexGrid::get_hex_noise() const { return _plain_noise; }
 Ref<FastNoiseLite> RidgeHexGrid::get_ridge_noise() const { return _ridge_noise; }
@@ -225,6 +482,7 @@ float RidgeHexGrid::get_ridge_top_offset() const { return _ridge_config.top_ridg
 float RidgeHexGrid::get_ridge_bottom_offset() const { return _ridge_config.bottom_ridge_offset; }
 float RidgeHexGrid::get_biomes_hill_level_ratio() const { return _biomes_hill_level_ratio; }
 float RidgeHexGrid::get_biomes_plain_hill_gain() const { return _biomes_plain_hill_gain; }
+float RidgeHexGrid::get_biomes_seamless_range() const { return _biomes_seamless_range; }
 Ref<Texture> RidgeHexGrid::get_plain_texture() const { return _texture.find(Biome::PLAIN)->second; }
 Ref<Texture> RidgeHexGrid::get_hill_texture() const { return _texture.find(Biome::HILL)->second; }
 Ref<Texture> RidgeHexGrid::get_water_texture() const { return _texture.find(Biome::WATER)->second; }
@@ -242,17 +500,17 @@ void RidgeHexGrid::init_hexmesh() {
     }
   }
 
+  Vector3Array centers;
+  for (auto& [id, o] : offsets) {
+    centers.push_back(o);
+  }
+  // centers of tiles are distinct, cache only spreads sampling of biomes noise over threads
+  NoiseCache biomes_noise;
+  biomes_noise.reset(_biomes_noise, Orientation::Plane, _diameter / 4);
+  biomes_noise.sample({centers}, _threads);
   std::unordered_map<int, float> altitudes;
-  for (auto row : _col_row_layout) {
-    for (auto val : row) {
-      int id = calculate_id(val.x, val.z);
-      Vector3 o = offsets[id];
-      if (_biomes_noise.ptr()) {
-        altitudes[id] = _biomes_noise->get_noise_2d(o.x, o.z);
-      } else {
-        altitudes[id] = 0;
-      }
-    }
+  for (auto& [id, o] : offsets) {
+    altitudes[id] = biomes_noise.get(o);
   }
 
   float min_z = std::numeric_limits<float>::max();
@@ -261,31 +519,45 @@ void RidgeHexGrid::init_hexmesh() {
     min_z = std::min(min_z, a);
     max_z = std::max(max_z, a);
   }
+  if (_seamless) {
+    min_z = -_biomes_seamless_range;
+    max_z = _biomes_seamless_range;
+    // noise beyond the range belongs to the lowest or the highest biome
+    for (auto& [id, a] : altitudes) {
+      a = std::clamp(a, min_z, max_z);
+    }
+  }
 
+  bool reuse = can_reuse_tiles();
+  TilesLayout previous;
+  // type of ridge mesh depends on biome, so meshes are reused by tiles of the same biome
+  std::unordered_map<Biome, std::vector<Ref<RidgeMesh>>> spare_meshes;
+  if (reuse) {
+    // tiles are changed in place, publish() shows their new meshes
+    previous = std::move(_tiles_layout);
+    for (std::vector<Tile*>& row : previous) {
+      for (Tile* tile : row) {
+        spare_meshes[dynamic_cast<BiomeTile*>(tile)->biome()].push_back(
+            Ref<RidgeMesh>(dynamic_cast<RidgeMesh*>(tile->mesh().ptr())));
+      }
+    }
+  } else {
+    retire_tiles();
+  }
   _tiles_layout.clear();
-  clean_children(*this);
+  _picker.reset();
+  _tile_index.clear();
   BiomeCalculator biome_calculator;
-  for (auto row : _col_row_layout) {
-    _tiles_layout.push_back({});
-    for (auto val : row) {
+  // meshes are created in layout order and tesselated in parallel, tiles are made of them afterwards
+  std::vector<Ref<RidgeMesh>> meshes;
+  std::vector<Biome> biomes;
+  for (int i = 0; i < static_cast<int>(_col_row_layout.size()); ++i) {
+    for (int j = 0; j < static_cast<int>(_col_row_layout[i].size()); ++j) {
+      Vector3i val = _col_row_layout[i][j];
       int id = calculate_id(val.x, val.z);
       Biome biome = biome_calculator.calculate_biome(min_z, max_z, altitudes[id]);
 
-      Ref<ShaderMaterial> mat;
-      mat.instantiate();
-      if (_shader.ptr()) {
-        mat->set_shader(_shader);
-      }
-      if (_texture[biome].ptr()) {
-        mat->set_shader_parameter("water_texture", _texture[Biome::WATER].ptr());
-        mat->set_shader_parameter("plain_texture", _texture[Biome::PLAIN].ptr());
-        mat->set_shader_parameter("hill_texture", _texture[Biome::HILL].ptr());
-        mat->set_shader_parameter("mountain_texture", _texture[Biome::MOUNTAIN].ptr());
-
-        mat->set_shader_parameter("top_offset", _ridge_config.top_ridge_offset);
-        mat->set_shader_parameter("bottom_offset", _ridge_config.bottom_ridge_offset);
-        mat->set_shader_parameter("hill_level_ratio", _biomes_hill_level_ratio);
-      }
+      Ref<ShaderMaterial> mat = _materials.find(_shader, static_cast<int>(biome));
 
       Hexagon hex = make_hexagon_at_position(offsets[id], _diameter);
 
@@ -297,18 +569,58 @@ void RidgeHexGrid::init_hexmesh() {
                                            .frame_offset = _frame_offset,
                                            .material = mat,
                                            .divisions = _divisions,
-                                           .clip_options = clip_options},
-          .plain_noise = _plain_noise,
-          .ridge_noise = _ridge_noise,
+                                           .clip_options = clip_options,
+                                           .indexed = _indexed,
+                                           .attributes = _mesh_attributes,
+                                           .direct_upload = _direct_upload},
       };
 
-      Ref<RidgeMesh> m = create_ridge_mesh(biome, hex, params);
+      Ref<RidgeMesh> m;
+      std::vector<Ref<RidgeMesh>>& spare = spare_meshes[biome];
+      if (spare.empty()) {
+        m = create_ridge_mesh(biome, hex, params);
+      } else {
+        m = spare.back();
+        spare.pop_back();
+        m->reset(hex, params);
+      }
+      meshes.push_back(m);
+      biomes.push_back(biome);
+    }
+  }
+
+  parallel_for(meshes.size(), _threads, [&meshes](int i) { meshes[i]->build(); });
+
+  int k = 0;
+  for (int i = 0; i < static_cast<int>(_col_row_layout.size()); ++i) {
+    _tiles_layout.push_back({});
+    for (int j = 0; j < static_cast<int>(_col_row_layout[i].size()); ++j, ++k) {
+      if (reuse) {
+        BiomeTile* tile = dynamic_cast<BiomeTile*>(previous[i][j]);
+        tile->reuse(meshes[k], biomes[k]);
+        _tiles_layout.back().push_back(tile);
+        continue;
+      }
+      Vector3i val = _col_row_layout[i][j];
       _tiles_layout.back().push_back(
-          make_non_ref<BiomeTile>(m, this, biome, OffsetCoordinates{.row = val.x, .col = val.z}));
+          add_tile(std::make_unique<BiomeTile>(meshes[k], biomes[k], OffsetCoordinates{.row = val.x, .col = val.z})));
     }
   }
 }
 
+void RidgeHexGrid::configure_material(Biome biome, Ref<ShaderMaterial> material) {
+  if (_texture[biome].ptr()) {
+    material->set_shader_parameter("water_texture", _texture[Biome::WATER].ptr());
+    material->set_shader_parameter("plain_texture", _texture[Biome::PLAIN].ptr());
+    material->set_shader_parameter("hill_texture", _texture[Biome::HILL].ptr());
+    material->set_shader_parameter("mountain_texture", _texture[Biome::MOUNTAIN].ptr());
+
+    material->set_shader_parameter("top_offset", _ridge_config.top_ridge_offset);
+    material->set_shader_parameter("bottom_offset", _ridge_config.bottom_ridge_offset);
+    material->set_shader_parameter("hill_level_ratio", _biomes_hill_level_ratio);
+  }
+}
+
 std::vector<TileMesh*> RidgeHexGrid::meshes() {
   std::vector<TileMesh*> res;
 
@@ -350,108 +662,160 @@ void RidgeHexGrid::init_biomes() {
   }
 }
 
-void RidgeHexGrid::calculate_neighbours(const GroupOfRidgeMeshes& group) {
-  auto member_of_group = [&group](RidgeMesh& ridge_hex_mesh) {
-    return std::find(group.begin(), group.end(), &ridge_hex_mesh) != group.end();
+void RidgeHexGrid::init_ridges(std::vector<RidgeGroup>& group, float ridge_offset) {
+  for (RidgeGroup& group : group) {
+    group.set_ridge_config(_ridge_config);
+    if (_seamless) {
+      group.init_local_ridges(ridge_offset);
+    } else {
+      group.init_ridges(_distance_map, ridge_offset, _divisions);
+    }
+  }
+  if (_seamless) {
+    calculate_local_distances_to_border(group);
+  }
+}
+
+void RidgeHexGrid::calculate_local_distances_to_border(std::vector<RidgeGroup>& groups) {
+  // tiles beyond this number of rings are at least two diameters away from corners of tile
+  constexpr int rings = 3;
+  const float max_distance = 2 * _diameter;
+  auto segment_distance = [](Vector2 p, Vector2 a, Vector2 b) {
+    Vector2 ab = b - a;
+    float t = std::clamp((p - a).dot(ab) / ab.length_squared(), 0.0f, 1.0f);
+    return p.distance_to(a + ab * t);
   };
-  for (auto& row : _tiles_layout) {
-    for (auto& tile_ptr : row) {
-      BiomeTile* tile = dynamic_cast<BiomeTile*>(tile_ptr);
-      RidgeMesh* ridge_hex_mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
-      if (std::find(group.begin(), group.end(), ridge_hex_mesh) == group.end()) {
-        continue;
-      }
-      CubeCoordinates cube_cur = tile->get_cube_coords();
-      Neighbours hexagon_neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
-      std::vector<CubeCoordinates> neighbours_hexes_coord = neighbours(cube_cur);
-
-      for (unsigned int i = 0; i < neighbours_hexes_coord.size(); ++i) {
-        CubeCoordinates n = neighbours_hexes_coord[i];
-        RidgeMesh* casted = dynamic_cast<RidgeMesh*>(_cube_to_hexagon[n]);
-        if (_cube_to_hexagon.contains(n) && member_of_group(*casted) && member_of_group(*ridge_hex_mesh)) {
-          hexagon_neighbours[i] = _cube_to_hexagon[n];
+
+  for (RidgeGroup& group : groups) {
+    for (RidgeMesh* mesh : group.meshes()) {
+      Vector3 center = mesh->get_center();
+      BiomeTile* tile = static_cast<BiomeTile*>(tile_at(cubeToOffset(pixelToCube(center.x, center.z, _diameter / 2))));
+      CubeCoordinates coords = tile->get_cube_coords();
+
+      std::vector<std::vector<Vector3>> borders;
+      for (int dq = -rings; dq <= rings; ++dq) {
+        for (int dr = std::max(-rings, -dq - rings); dr <= std::min(rings, -dq + rings); ++dr) {
+          Tile* other = _tile_index.at(coords + CubeCoordinates{.q = dq, .r = dr, .s = -dq - dr});
+          if (other && static_cast<BiomeTile*>(other)->biome() != tile->biome()) {
+            borders.push_back(other->mesh()->inner_mesh()->base().points());
+          }
         }
       }
 
-      tile->set_neighbours(hexagon_neighbours);
+      for (Vector3 corner : mesh->inner_mesh()->base().points()) {
+        Vector2 p(corner.x, corner.z);
+        float distance = max_distance;
+        for (const std::vector<Vector3>& points : borders) {
+          for (unsigned int i = 0; i < points.size(); ++i) {
+            Vector3 a = points[i];
+            Vector3 b = points[(i + 1) % points.size()];
+            distance = std::min(distance, segment_distance(p, Vector2(a.x, a.z), Vector2(b.x, b.z)));
+          }
+        }
+        // shared corners get the same distance from every tile
+        _distance_map[VertexToNormalDiscretizer::get_discrete_vertex(corner, _diameter / (_divisions * 2))] = distance;
+      }
     }
   }
 }
 
-void RidgeHexGrid::assign_neighbours(const GroupOfRidgeMeshes& group) {
-  for (auto& row : _tiles_layout) {
-    for (auto& tile_ptr : row) {
-      BiomeTile* tile = dynamic_cast<BiomeTile*>(tile_ptr);
-      RidgeMesh* ridge_mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
-      if (std::find(group.begin(), group.end(), ridge_mesh) == group.end()) {
-        continue;
+void RidgeHexGrid::init_neighbours() {
+  // groups are connected tiles of the same biome, so neighbours of tile in its group are adjacent tiles of its biome
+  // and adjacency of the whole grid is built in one pass over index of tiles
+  for (std::vector<Tile*>& row : _tiles_layout) {
+    for (Tile* tile_ptr : row) {
+      // tiles of grid are always BiomeTile with RidgeMesh
+      BiomeTile* tile = static_cast<BiomeTile*>(tile_ptr);
+      Neighbours neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+      std::array<Tile*, 6> adjacent = _tile_index.neighbours(tile->get_cube_coords());
+      for (int i = 0; i < 6; ++i) {
+        if (adjacent[i] && static_cast<BiomeTile*>(adjacent[i])->biome() == tile->biome()) {
+          neighbours[i] = adjacent[i]->mesh().ptr();
+        }
       }
-      ridge_mesh->set_neighbours(tile->neighbours());
+      tile->set_neighbours(neighbours);
+      static_cast<RidgeMesh*>(tile->mesh().ptr())->set_neighbours(neighbours);
     }
   }
+  // distances to borders of groups are calculated again by ridges stages
+  _distance_map.clear();
 }
 
-void RidgeHexGrid::init_ridges(std::vector<RidgeGroup>& group, float ridge_offset) {
-  for (RidgeGroup& group : group) {
-    group.init_ridges(_distance_map, ridge_offset, _divisions);
-  }
+float RidgeHexGrid::noise_cache_step() const {
+  // quarter of distance between neighbouring vertices of tesselation
+  return _diameter / (_divisions * 2) / 4;
 }
 
-void RidgeHexGrid::prepare_heights_calculation() {
-  for (RidgeGroup& group : all_groups()) {
-    calculate_neighbours(group.meshes());
-    assign_neighbours(group.meshes());
+void RidgeHexGrid::calculate_initial_heights(const std::vector<RidgeMesh*>& meshes, bool all) {
+  std::vector<Vector3Array> vertices;
+  for (RidgeMesh* mesh : meshes) {
+    vertices.push_back(mesh->inner_mesh()->get_vertices());
   }
-  init_ridges(_mountain_groups, _ridge_config.top_ridge_offset);
-  init_ridges(_water_groups, _ridge_config.bottom_ridge_offset);
+  NoiseCache plain_noise;
+  plain_noise.reset(_plain_noise, Orientation::Plane, noise_cache_step());
+  plain_noise.sample(vertices, _threads);
+  parallel_for(meshes.size(), _threads,
+               [&meshes, &plain_noise](int i) { meshes[i]->calculate_initial_heights(plain_noise); });
 
   float global_min_y = std::numeric_limits<float>::max();
   float global_max_y = std::numeric_limits<float>::min();
-  auto calculate_initial = [&global_max_y, &global_min_y](const GroupOfRidgeMeshes& group) {
-    for (auto* mesh : group) {
-      mesh->calculate_initial_heights();
-      auto [mesh_min_z, mesh_max_z] = mesh->get_min_max_height();
-      global_min_y = std::min(global_min_y, mesh_min_z);
-      global_max_y = std::max(global_max_y, mesh_max_z);
-    }
-  };
-  for (RidgeGroup& group : all_groups()) {
-    group.fmap(calculate_initial);
+  for (RidgeMesh* mesh : meshes) {
+    auto [mesh_min_z, mesh_max_z] = mesh->get_min_max_height();
+    global_min_y = std::min(global_min_y, mesh_min_z);
+    global_max_y = std::max(global_max_y, mesh_max_z);
   }
 
-  float amplitude = global_max_y - global_min_y;
-  float compression_factor = _biomes_plain_hill_gain / amplitude;
-
-  auto shift_compress = [global_min_y, compression_factor](const GroupOfRidgeMeshes& group) {
-    for (auto* mesh : group) {
-      mesh->set_shift_compress(-global_min_y, compression_factor);
-    }
-  };
-
-  for (RidgeGroup& group : all_groups()) {
-    group.fmap(shift_compress);
+  // initial heights don't depend on ridges, so range of all tiles is still valid if only some of them are recalculated
+  if (_seamless) {
+    // noise is in [-1, 1]
+    _heights_shift = 1;
+    _heights_compression = _biomes_plain_hill_gain / 2;
+  } else if (all) {
+    float amplitude = global_max_y - global_min_y;
+    _heights_shift = -global_min_y;
+    _heights_compression = _biomes_plain_hill_gain / amplitude;
+  }
+  for (RidgeMesh* mesh : meshes) {
+    mesh->set_shift_compress(_heights_shift, _heights_compression);
   }
 }
 
-void RidgeHexGrid::assign_cube_coordinates_map() {
-  for (auto& row : _tiles_layout) {
-    for (auto& tile_ptr : row) {
-      BiomeTile* tile = dynamic_cast<BiomeTile*>(tile_ptr);
-      _cube_to_hexagon[tile->get_cube_coords()] = tile_ptr->mesh().ptr();
+void RidgeHexGrid::calculate_final_heights(const std::vector<RidgeMesh*>& meshes) {
+  // only ridge based heights use noise, x and z of vertices are the same as for initial heights
+  std::vector<Vector3Array> vertices;
+  for (RidgeMesh* mesh : meshes) {
+    if (is_water_mesh(mesh) || is_mountain_mesh(mesh)) {
+      vertices.push_back(mesh->inner_mesh()->get_vertices());
     }
   }
+  NoiseCache ridge_noise;
+  ridge_noise.reset(_ridge_noise, Orientation::Plane, noise_cache_step());
+  ridge_noise.sample(vertices, _threads);
+
+  parallel_for(meshes.size(), _threads, [this, &meshes, &ridge_noise](int i) {
+    RidgeMesh* mesh = meshes[i];
+    mesh->calculate_final_heights(_distance_map, ridge_noise, _diameter, _divisions);
+    // water and plain tiles are nearly flat, most of their triangles can be merged
+    if (_decimation_tolerance > 0 && (is_water_mesh(mesh) || is_plain_mesh(mesh))) {
+      mesh->decimate_planar(_decimation_tolerance);
+    }
+    mesh->calculate_normals();
+  });
 }
 
-void RidgeHexGrid::calculate_final_heights() {
-  for (auto& row : _tiles_layout) {
-    for (auto& tile_ptr : row) {
-      RidgeMesh* mesh = dynamic_cast<RidgeMesh*>(tile_ptr->mesh().ptr());
-
-      mesh->calculate_final_heights(_distance_map, _diameter, _divisions);
-      mesh->calculate_normals();
-      mesh->update();
+Dictionary RidgeHexGrid::get_decimation_stats() const {
+  DecimationStats decimation;
+  if (!is_generating()) {
+    for (const std::vector<Tile*>& row : _tiles_layout) {
+      for (const Tile* tile : row) {
+        decimation += tile->mesh()->inner_mesh()->decimation_stats();
+      }
     }
   }
+  Dictionary result;
+  result["triangles_before"] = decimation.triangles_before;
+  result["triangles_after"] = decimation.triangles_after;
+  return result;
 }
 
 // RectRidgeHexGrid definitions
@@ -470,18 +834,27 @@ void RectRidgeHexGrid::_bind_methods() {
 }
 
 void RectRidgeHexGrid::set_height(const int p_height) {
+  if (queue_if_generating("set_height", p_height)) {
+    return;
+  }
   _height = p_height > 1 ? p_height : 1;
-  init();
+  request_init();
 }
 
 void RectRidgeHexGrid::set_width(const int p_width) {
+  if (queue_if_generating("set_width", p_width)) {
+    return;
+  }
   _width = p_width > 1 ? p_width : 1;
-  init();
+  request_init();
 }
 
 void RectRidgeHexGrid::set_clipped_option(const bool p_clipped_option) {
+  if (queue_if_generating("set_clipped_option", p_clipped_option)) {
+    return;
+  }
   _clipped = p_clipped_option;
-  init();
+  request_init();
 }
 
 int RectRidgeHexGrid::get_height() const { return _height; }
@@ -513,15 +886,12 @@ BiomeGroups RectRidgeHexGrid::collect_biome_groups(Biome b) {
       }
       RidgeMesh* mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
       u.push(flat(i, j), mesh);
-      u.make_union(flat(i, j), flat(i - 1, j));
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i - 1, j + 1}))) {
-        u.make_union(flat(i, j), flat(i - 1, j + 1));
-      }
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i - 1, j - 1}))) {
-        u.make_union(flat(i, j), flat(i - 1, j - 1));
-      }
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i, j - 1}))) {
-        u.make_union(flat(i, j), flat(i, j - 1));
+      // tiles which are not pushed yet are united when their turn comes
+      for (Tile* neighbour : _tile_index.neighbours(tile->get_cube_coords())) {
+        if (neighbour) {
+          OffsetCoordinates n = neighbour->get_offset_coords();
+          u.make_union(flat(i, j), flat(n.row, n.col));
+        }
       }
     }
   }
@@ -546,8 +916,11 @@ void HexagonalRidgeHexGrid::_bind_methods() {
 }
 
 void HexagonalRidgeHexGrid::set_size(const int p_size) {
+  if (queue_if_generating("set_size", p_size)) {
+    return;
+  }
   _size = p_size > 1 ? p_size : 1;
-  init();
+  request_init();
 }
 
 int HexagonalRidgeHexGrid::get_size() const { return _size; }
@@ -577,15 +950,12 @@ BiomeGroups HexagonalRidgeHexGrid::collect_biome_groups(Biome b) {
       int j = offset_coords.col;
       RidgeMesh* mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
       u.push(flat(i, j), mesh);
-      u.make_union(flat(i, j), flat(i - 1, j));
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i - 1, j + 1}))) {
-        u.make_union(flat(i, j), flat(i - 1, j + 1));
-      }
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i - 1, j - 1}))) {
-        u.make_union(flat(i, j), flat(i - 1, j - 1));
-      }
-      if (_cube_to_hexagon.contains(offsetToCube(OffsetCoordinates{i, j - 1}))) {
-        u.make_union(flat(i, j), flat(i, j - 1));
+      // tiles which are not pushed yet are united when their turn comes
+      for (Tile* neighbour : _tile_index.neighbours(tile->get_cube_coords())) {
+        if (neighbour) {
+          OffsetCoordinates n = neighbour->get_offset_coords();
+          u.make_union(flat(i, j), flat(n.row, n.col));
+        }
       }
     }
   }
@@ -12,6 +12,8 @@
 #include "ridge_impl/ridge_based_object.h"  // for RidgeBased
 #include "ridge_impl/ridge_group.h"         // for BiomeGroups, GroupOfRidge...
 #include "ridge_impl/ridge_set.h"
+#include "tal/arrays.h"     // for Dictionary
+#include "tal/material.h"   // for ShaderMaterial
 #include "tal/noise.h"      // for FastNoiseLite
 #include "tal/reference.h"  // for Ref
 #include "tal/texture.h"    // for Texture
@@ -63,16 +65,90 @@ class RidgeHexGrid : public HexGrid, public RidgeBased {
   void set_biomes_plain_hill_gain(float p_biomes_plain_hill_gain);
   float get_biomes_plain_hill_gain() const;
 
+  /**
+   * @brief Property shared with Godot inspector. Biomes of seamless grid are assigned by biomes noise normalized from
+   * [-range, range] instead of range over grid. Fractal noise rarely reaches its nominal range [-1, 1], so the default
+   * is close to the range noise actually covers and gives about the same mix of biomes as non-seamless grid
+   */
+  void set_biomes_seamless_range(float p_biomes_seamless_range);
+  float get_biomes_seamless_range() const;
+
   void set_smooth_normals(bool p_smooth_normals);
   bool get_smooth_normals() const;
 
+  void set_decimation_tolerance(float p_decimation_tolerance);
+  float get_decimation_tolerance() const;
+
+  /**
+   * @brief Number of triangles of tiles before and after planar decimation, keys are "triangles_before" and
+   * "triangles_after". Tiles which aren't decimated count as zero
+   */
+  Dictionary get_decimation_stats() const;
+
+  /**
+   * @brief Property shared with Godot inspector. Number of threads of WorkerThreadPool tesselating tiles and
+   * calculating their heights, 0 means all threads of pool. Generated terrain is the same for any number of threads
+   */
+  void set_threads(int p_threads);
+  int get_threads() const;
+
+  /**
+   * @brief Stages of generation. Each property invalidates only stages depending on it, see regenerate()
+   */
+  enum Stage {
+    STAGE_TILES = 1 << 0,             // layout, biomes, tiles, groups and their neighbours
+    STAGE_MATERIALS = 1 << 1,         // shader parameters of materials
+    STAGE_MOUNTAIN_RIDGES = 1 << 2,   // ridges of mountain groups
+    STAGE_WATER_RIDGES = 1 << 3,      // ridges of water groups
+    STAGE_MOUNTAIN_HEIGHTS = 1 << 4,  // heights of mountain tiles
+    STAGE_WATER_HEIGHTS = 1 << 5,     // heights of water tiles
+    STAGE_HEIGHTS = 1 << 6,           // heights of all tiles
+    STAGE_NORMALS = 1 << 7,           // normals, levels of detail and chunks
+  };
+
+  /**
+   * @brief Marks stages and all stages depending on them as dirty. Dirty stages are run once at the end of frame, no
+   * matter how many times they are invalidated before that
+   */
+  void regenerate(int p_stages);
+
+  /**
+   * @brief Runs dirty stages immediately. Postponed until the end of generation if it's running
+   */
+  void regenerate_dirty();
+
+  void generate_async() override;
+  void finish_generation() override;
+
+  /**
+   * @brief Copies generation settings of other grid. Layout and size are defined by subclasses, so they aren't copied
+   */
+  void copy_settings(const RidgeHexGrid& other);
+
  protected:
   DiscreteVertexToDistance _distance_map;
+  /**
+   * @brief Tiles are the same as tiles at the same position of any other seamless grid with the same settings: biomes
+   * and heights are normalized by fixed range of noise instead of range over grid, ridges and distances to borders
+   * of groups depend only on neighbourhood of tile. Outermost tiles of seamless grid don't have full neighbourhood
+   */
+  bool _seamless{false};
 
   static void _bind_methods();
 
   void init() override;
+  void init_materials() override;
+  void generate() override;
   void init_hexmesh() override;
+  /**
+   * @brief Calculates given stages without creating nodes or uploading meshes, so it may run on background thread.
+   * Tiles are shown by publish() afterwards. Returns early between stages if generation is cancelled
+   */
+  virtual void regenerate_stages(int stages);
+  /**
+   * @brief Called after heights and normals of tiles are final, before levels of detail are built
+   */
+  virtual void finalize_tiles() {}
 
  private:
   std::unordered_map<Biome, Ref<Texture>> _texture;
@@ -82,21 +158,47 @@ class RidgeHexGrid : public HexGrid, public RidgeBased {
   Ref<FastNoiseLite> _ridge_noise;
 
   bool _smooth_normals{false};
+  // 0 disables decimation of water and plain tiles
+  float _decimation_tolerance{0.0};
+  int _threads{0};
   float _biomes_hill_level_ratio{0.7};
   float _biomes_plain_hill_gain{0.1f};
-
-  void calculate_neighbours(const GroupOfRidgeMeshes& group);
-  void assign_neighbours(const GroupOfRidgeMeshes& group);
+  float _biomes_seamless_range{0.6f};
+
+  int _dirty{0};
+  bool _regeneration_scheduled{false};
+  // shift and compression of initial heights of all tiles, reused when heights of some biomes are recalculated
+  float _heights_shift{0.0f};
+  float _heights_compression{1.0f};
+
+  static int with_dependent_stages(int stages);
+  void on_biomes_noise_changed();
+  void on_plain_noise_changed();
+  void on_ridge_noise_changed();
+  void configure_material(Biome biome, Ref<ShaderMaterial> material);
+  std::vector<RidgeMesh*> height_meshes(int stages);
   void init_ridges(std::vector<RidgeGroup>& group, float ridge_offset);
+  /**
+   * @brief Distances from corners of tiles to the nearest tile of other biome, capped at two diameters. Unlike
+   * distances propagated by RidgeGroup they don't depend on the rest of group
+   */
+  void calculate_local_distances_to_border(std::vector<RidgeGroup>& groups);
 
   virtual BiomeGroups collect_biome_groups(Biome b) = 0;
   virtual ClipOptions get_clip_options(int row, int col) const = 0;
 
   void init_biomes();
-  void prepare_heights_calculation();
-  void calculate_final_heights();
+  /**
+   * @brief Sets neighbours of every tile within its group. Linear in number of tiles
+   */
+  void init_neighbours();
+  /**
+   * @brief Noise of heights is sampled once per distinct vertex of meshes before heights are calculated, see NoiseCache
+   */
+  void calculate_initial_heights(const std::vector<RidgeMesh*>& meshes, bool all);
+  void calculate_final_heights(const std::vector<RidgeMesh*>& meshes);
+  float noise_cache_step() const;
 
-  void assign_cube_coordinates_map();
   void calculate_normals() override;
 
   std::vector<TileMesh*> meshes();
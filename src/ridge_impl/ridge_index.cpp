@@ -0,0 +1,95 @@
+#include "ridge_impl/ridge_index.h"
+
+#include <algorithm>  // for clamp, max, min, sort
+#include <cmath>      // for floor
+#include <utility>    // for move
+
+namespace sota {
+
+// PointGrid definitions
+PointGrid::PointGrid(std::vector<Vector3> points, float cell_size, bool flat)
+    : _points(std::move(points)), _cell_size(cell_size), _flat(flat) {
+  if (_points.empty()) {
+    return;
+  }
+  Vector3 min = _points[0];
+  Vector3 max = _points[0];
+  for (Vector3 p : _points) {
+    min = Vector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+    max = Vector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+  }
+  _origin = min;
+  long long max_cells = std::max<long long>(64, 4 * _points.size());
+  while (true) {
+    _dimensions = Vector3i(static_cast<int>((max.x - min.x) / _cell_size) + 1,
+                           _flat ? 1 : static_cast<int>((max.y - min.y) / _cell_size) + 1,
+                           static_cast<int>((max.z - min.z) / _cell_size) + 1);
+    if (static_cast<long long>(_dimensions.x) * _dimensions.y * _dimensions.z <= max_cells) {
+      break;
+    }
+    _cell_size *= 2;
+  }
+
+  _cells.resize(_dimensions.x * _dimensions.y * _dimensions.z);
+  for (int i = 0; i < static_cast<int>(_points.size()); ++i) {
+    Vector3i c = cell(_points[i]);
+    _cells[(c.x * _dimensions.y + c.y) * _dimensions.z + c.z].push_back(i);
+  }
+}
+
+Vector3i PointGrid::cell(Vector3 p) const {
+  auto coordinate = [this](float value, float origin, int dimension) {
+    int c = static_cast<int>(std::floor((value - origin) / _cell_size));
+    return std::clamp(c, -1, dimension);
+  };
+  // query points outside of grid get coordinates of cells next to its border
+  return Vector3i(coordinate(p.x, _origin.x, _dimensions.x), _flat ? 0 : coordinate(p.y, _origin.y, _dimensions.y),
+                  coordinate(p.z, _origin.z, _dimensions.z));
+}
+
+std::vector<int> PointGrid::within(Vector3 p, float radius) const {
+  std::vector<int> res;
+  if (_points.empty()) {
+    return res;
+  }
+  Vector3i from = cell(p - Vector3(radius, radius, radius));
+  Vector3i to = cell(p + Vector3(radius, radius, radius));
+  // one more cell on each side covers rounding of cell coordinates
+  for (int x = std::max(0, from.x - 1); x <= std::min(_dimensions.x - 1, to.x + 1); ++x) {
+    for (int y = std::max(0, from.y - 1); y <= std::min(_dimensions.y - 1, to.y + 1); ++y) {
+      for (int z = std::max(0, from.z - 1); z <= std::min(_dimensions.z - 1, to.z + 1); ++z) {
+        for (int i : bucket(Vector3i(x, y, z))) {
+          if (_points[i].distance_to(p) < radius) {
+            res.push_back(i);
+          }
+        }
+      }
+    }
+  }
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+// RidgeIndex definitions
+RidgeIndex::RidgeIndex(std::vector<Ridge*> ridges, float cell_size, bool flat) : _ridges(std::move(ridges)) {
+  std::vector<Vector3> ends;
+  for (const Ridge* ridge : _ridges) {
+    ends.push_back(ridge->start());
+    ends.push_back(ridge->end());
+  }
+  _ends = PointGrid(std::move(ends), cell_size, flat);
+}
+
+std::vector<const Ridge*> RidgeIndex::ridges_near(Vector3 center, float radius) const {
+  std::vector<int> ends = _ends.within(center, radius);
+  std::vector<const Ridge*> res;
+  for (int i = 0; i < static_cast<int>(ends.size()); ++i) {
+    // start and end of the same ridge are adjacent in sorted indices
+    if (i == 0 || ends[i] / 2 != ends[i - 1] / 2) {
+      res.push_back(_ridges[ends[i] / 2]);
+    }
+  }
+  return res;
+}
+
+}  // namespace sota
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>  // for vector
+
+#include "ridge_impl/ridge.h"  // for Ridge
+#include "tal/vector3.h"       // for Vector3
+#include "tal/vector3i.h"      // for Vector3i
+
+namespace sota {
+
+/**
+ * @brief Uniform grid of buckets of points. Flat grid buckets points by x and z, grid of polyhedron buckets them in
+ * 3d. Cells are enlarged if there are many more cells than points, so memory is linear in number of points
+ */
+class PointGrid {
+ public:
+  PointGrid() = default;
+  PointGrid(std::vector<Vector3> points, float cell_size, bool flat);
+
+  const std::vector<Vector3>& points() const { return _points; }
+
+  /**
+   * @brief Indices of points closer than radius to p in 3d, in ascending order
+   */
+  std::vector<int> within(Vector3 p, float radius) const;
+
+ private:
+  std::vector<Vector3> _points;
+  float _cell_size{1.0};
+  bool _flat{true};
+  Vector3 _origin;
+  Vector3i _dimensions;
+  // indices of points of every cell in ascending order
+  std::vector<std::vector<int>> _cells;
+
+  Vector3i cell(Vector3 p) const;
+  const std::vector<int>& bucket(Vector3i c) const { return _cells[(c.x * _dimensions.y + c.y) * _dimensions.z + c.z]; }
+};
+
+/**
+ * @brief Ridges of group with grid of their ends, shared by all meshes of group. Ridges near tile are found without
+ * visiting all ridges of group
+ */
+class RidgeIndex {
+ public:
+  RidgeIndex() = default;
+  RidgeIndex(std::vector<Ridge*> ridges, float cell_size, bool flat);
+
+  /**
+   * @brief Ridges with start or end closer than radius to center, in order of group
+   */
+  std::vector<const Ridge*> ridges_near(Vector3 center, float radius) const;
+
+ private:
+  std::vector<Ridge*> _ridges;
+  // start of ridge i is point 2i, its end is point 2i + 1
+  PointGrid _ends;
+};
+
+}  // namespace sota
@@ -2,44 +2,32 @@
 
 #include <algorithm>  // for min, any_of
 #include <iterator>   // for back_insert_it...
+#include <limits>     // for numeric_limits
+#include <memory>     // for make_unique
 #include <set>        // for set
-
-#include "core/general_utility.h"  // for MeshProcessor
-#include "core/mesh.h"             // for SotaMesh
-#include "misc/discretizer.h"      // for Dicretizer
-#include "misc/types.h"            // for Neighbours
-#include "misc/utilities.h"        // for to_point_divis...
-#include "primitives/polygon.h"    // for RegularPolygon
-#include "tal/arrays.h"            // for Vector3Array
-#include "tal/callable.h"          // for Callable
-#include "tal/godot_core.h"        // for print
-#include "tal/noise.h"             // for FastNoiseLite
-#include "tal/reference.h"         // for Ref
-#include "tal/vector2.h"           // for Vector2
-#include "tal/vector3.h"           // for Vector3
-#include "tile_mesh.h"             // for TileMesh
+#include <span>       // for span
+
+#include "core/general_utility.h"    // for MeshProcessor
+#include "core/hex_mesh.h"           // for HexMesh
+#include "core/mesh.h"               // for SotaMesh
+#include "core/noise_cache.h"        // for NoiseCache
+#include "misc/discretizer.h"        // for Dicretizer
+#include "misc/types.h"              // for Neighbours
+#include "misc/utilities.h"          // for to_point_divis...
+#include "primitives/polygon.h"      // for RegularPolygon
+#include "ridge_impl/ridge_index.h"  // for RidgeIndex
+#include "tal/arrays.h"              // for Vector3Array
+#include "tal/godot_core.h"          // for print, printerr
+#include "tal/reference.h"           // for Ref
+#include "tal/vector2.h"             // for Vector2
+#include "tal/vector3.h"             // for Vector3
+#include "tile_mesh.h"               // for TileMesh
 
 namespace sota {
 class Ridge;
 
 void RidgeMesh::_bind_methods() {}
 
-void RidgeMesh::set_plain_noise(Ref<FastNoiseLite> p_noise) {
-  _plain_noise = p_noise;
-  if (_plain_noise.ptr()) {
-    _plain_noise->connect("changed", Callable(_mesh.ptr(), "request_update"));
-    _mesh->update();
-  }
-}
-
-void RidgeMesh::set_ridge_noise(Ref<FastNoiseLite> p_ridge_noise) {
-  _ridge_noise = p_ridge_noise;
-  if (_ridge_noise.ptr()) {
-    _ridge_noise->connect("changed", Callable(_mesh.ptr(), "request_update"));
-    _mesh->update();
-  }
-}
-
 void RidgeMesh::calculate_corner_points_distances_to_border(DiscreteVertexToDistance& distance_map, int divisions) {
   float diameter = _mesh->get_R() * 2;
   // TODO duplicated
@@ -79,7 +67,9 @@ void RidgeMesh::shift_compress() {
   if (!_processor) {
     print("processor of RidgeMesh object is nullptr");
   }
-  _mesh->set_vertices(_processor->shift_compress(_mesh->get_vertices(), _y_shift, _y_compress, center.y));
+  _mesh->edit_vertices([this, center](std::span<Vector3> vertices) {
+    _processor->shift_compress(vertices, _y_shift, _y_compress, center.y);
+  });
 }
 
 std::set<int> RidgeMesh::get_exclude_border_set() const {
@@ -104,8 +94,8 @@ std::set<int> RidgeMesh::get_exclude_border_set() const {
 }
 
 void RidgeMesh::calculate_ridge_based_heights(std::function<double(double, double, double)> interpolation_func,
-                                              float ridge_offset, DiscreteVertexToDistance& distance_map,
-                                              int divisions) {
+                                              float ridge_offset, const DiscreteVertexToDistance& distance_map,
+                                              const NoiseCache& ridge_noise, int divisions) {
   shift_compress();
 
   std::vector<Vector3> neighbours_corner_points;
@@ -116,26 +106,47 @@ void RidgeMesh::calculate_ridge_based_heights(std::function<double(double, doubl
     }
   }
 
-  auto vertices = _mesh->get_vertices();
-
+  RidgeIndex no_ridges;
+  const RidgeIndex& ridges = _ridges ? *_ridges : no_ridges;
   float diameter = _mesh->get_R() * 2;
-  vertices = _processor->calculate_ridge_based_heights(
-      vertices, _mesh->base(), _ridges, neighbours_corner_points, _mesh->get_R(), get_exclude_border_set(), diameter,
-      divisions, distance_map, _ridge_noise, ridge_offset, interpolation_func, _min_height, _max_height);
-
-  _mesh->set_vertices(vertices);
+  _mesh->edit_vertices([&](std::span<Vector3> vertices) {
+    _processor->calculate_ridge_based_heights(vertices, _mesh->base(), ridges, neighbours_corner_points,
+                                              _mesh->get_R(), get_exclude_border_set(), diameter, divisions,
+                                              distance_map, ridge_noise, ridge_offset, interpolation_func,
+                                              _min_height, _max_height);
+  });
 }
 
-void RidgeMesh::calculate_initial_heights() {
+void RidgeMesh::calculate_initial_heights(const NoiseCache& plain_noise) {
   auto normal = _mesh->base().normal();
   _initial_vertices = _mesh->get_vertices();
+  // heights may be calculated again for the same mesh
+  _min_height = std::numeric_limits<float>::max();
+  _max_height = std::numeric_limits<float>::min();
+
+  _mesh->edit_vertices([this, &plain_noise, normal](std::span<Vector3> vertices) {
+    _processor->calculate_initial_heights(vertices, plain_noise, _min_height, _max_height, normal);
+  });
+}
 
-  // TODO Pipe inputs/outputs
-  auto vertices = _mesh->get_vertices();
-  _processor->calculate_initial_heights(vertices, _plain_noise, _min_height, _max_height, normal);
-  _mesh->set_vertices(vertices);
+Vector3Array RidgeMesh::initial_noise_points() const {
+  Vector3Array points = _mesh->get_vertices();
+  if (_mesh->get_orientation() != Orientation::Plane) {
+    // vertices are moved to unit sphere before noise is read, see VolumeMeshProcessor
+    Vector3* p = points.ptrw();
+    for (int i = 0; i < points.size(); ++i) {
+      p[i] += p[i].normalized() * (1 - p[i].length());
+    }
+  }
+  return points;
+}
 
-  _mesh->update();
+Vector3Array RidgeMesh::final_noise_points() const {
+  // noise is read after vertices are shifted and compressed, see calculate_ridge_based_heights
+  Vector3Array points = _mesh->get_vertices();
+  _processor->shift_compress(std::span<Vector3>(points.ptrw(), points.size()), _y_shift, _y_compress,
+                             _mesh->base().center().y);
+  return points;
 }
 
 std::vector<TileMesh*> RidgeMesh::get_neighbours() const {
@@ -150,4 +161,26 @@ void RidgeMesh::set_shift_compress(float y_shift, float y_compress) {
   _y_compress = y_compress;
 }
 
+void RidgeMesh::build() {
+  _mesh->build();
+  if (_mesh->get_orientation() == Orientation::Plane) {
+    _processor = std::make_unique<FlatMeshProcessor>(FlatMeshProcessor());
+  } else {
+    _processor = std::make_unique<VolumeMeshProcessor>(VolumeMeshProcessor(_mesh->get_vertices()));
+  }
+}
+
+void RidgeMesh::reset(Hexagon hex, RidgeHexMeshParams params) {
+  HexMesh* mesh = dynamic_cast<HexMesh*>(_mesh.ptr());
+  if (!mesh) {
+    printerr("Only hexagonal RidgeMesh can be reset");
+    return;
+  }
+  _ridges = nullptr;
+  _neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+  _y_shift = 0.0f;
+  _y_compress = 1.0f;
+  mesh->reset(hex, params.hex_mesh_params);
+}
+
 }  // namespace sota
@@ -3,7 +3,7 @@
 #include <functional>  // for function
 #include <limits>      // for numeric_limits
 #include <map>         // for map
-#include <memory>      // for make_unique, unique_ptr
+#include <memory>      // for make_unique, shared_ptr, unique_ptr
 #include <set>         // for set
 #include <utility>     // for pair
 #include <vector>      // for vector
@@ -11,6 +11,7 @@
 #include "core/general_utility.h"  // for FlatMeshProcessor, MeshProc...
 #include "core/hex_mesh.h"         // for HexMeshParams, HexMesh
 #include "core/mesh.h"             // for SotaMesh, Orientation, Orie...
+#include "core/noise_cache.h"      // for NoiseCache
 #include "core/pent_mesh.h"        // for PentagonMeshParams, PentMesh
 #include "core/tile_mesh.h"        // for TileMesh
 #include "core/utils.h"
@@ -19,24 +20,20 @@
 #include "primitives/hexagon.h"   // for Hexagon
 #include "primitives/pentagon.h"  // for Pentagon
 #include "ridge_impl/ridge.h"
-#include "tal/arrays.h"     // for Vector3Array
-#include "tal/noise.h"      // for FastNoiseLite
-#include "tal/reference.h"  // for Ref
-#include "tal/vector3.h"    // for Vector3
+#include "ridge_impl/ridge_index.h"  // for RidgeIndex
+#include "tal/arrays.h"              // for Vector3Array
+#include "tal/reference.h"           // for Ref
+#include "tal/vector3.h"             // for Vector3
 
 namespace sota {
 class Ridge;
 
 struct RidgeHexMeshParams {
   HexMeshParams hex_mesh_params;
-  Ref<FastNoiseLite> plain_noise{nullptr};
-  Ref<FastNoiseLite> ridge_noise{nullptr};
 };
 
 struct RidgePentagonMeshParams {
   PentagonMeshParams pentagon_mesh_params;
-  Ref<FastNoiseLite> plain_noise{nullptr};
-  Ref<FastNoiseLite> ridge_noise{nullptr};
 };
 
 class RidgeMesh : public TileMesh {
@@ -53,21 +50,40 @@ class RidgeMesh : public TileMesh {
   std::pair<float, float> get_min_max_height() const { return {_min_height, _max_height}; }
 
   // setters
-  void set_plain_noise(Ref<FastNoiseLite> plain_noise);
-  void set_ridge_noise(Ref<FastNoiseLite> ridge_noise);
   void set_neighbours(Neighbours p_neighbours) { _neighbours = p_neighbours; }
-  void set_ridges(std::vector<Ridge*> r) { _ridges = r; }
+  void set_ridges(std::shared_ptr<const RidgeIndex> r) { _ridges = r; }
   void set_shift_compress(float y_shift, float y_compress);
 
+  /**
+   * @brief Moves mesh to other hexagon and replaces its parameters, as if it was made again by make_ridge_hex_mesh.
+   * Calculated ridges, neighbours and heights are dropped, mesh is tesselated again by build()
+   */
+  void reset(Hexagon hex, RidgeHexMeshParams params);
+
   // calculation
   void calculate_corner_points_distances_to_border(DiscreteVertexToDistance& distance_map, int divisions);
-  void calculate_initial_heights();
-  virtual void calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) = 0;
+  // calculation doesn't upload mesh, so it may run on worker thread. Noise is read from cache shared by all tiles
+  void calculate_initial_heights(const NoiseCache& plain_noise);
+  virtual void calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                                       float diameter, int divisions) = 0;
+  /**
+   * @brief Points at which calculate_initial_heights() reads noise, so they can be sampled into cache beforehand
+   */
+  Vector3Array initial_noise_points() const;
+  /**
+   * @brief Points at which ridge based heights read noise. Valid after initial heights and set_shift_compress()
+   */
+  Vector3Array final_noise_points() const;
 
   void calculate_normals() { _mesh->calculate_normals(); }
   void update() { _mesh->update(); }
   void recalculate_all_except_vertices() { _mesh->recalculate_all_except_vertices(); }
-  void init() { _mesh->init(); }
+  /**
+   * @brief Tesselates mesh without uploading it, see SotaMesh::build(). Meshes don't share state, so they may be built
+   * in parallel
+   */
+  void build();
+  DecimationStats decimate_planar(float tolerance) { return _mesh->decimate_planar(tolerance); }
   Vector3 get_center() { return _mesh->get_center(); }
   SotaMesh* inner_mesh() const override { return _mesh.ptr(); }
 
@@ -75,16 +91,10 @@ class RidgeMesh : public TileMesh {
 
  protected:
   RidgeMesh(Hexagon hex, RidgeHexMeshParams params)
-      : _mesh(Ref<SotaMesh>(memnew(HexMesh(hex, params.hex_mesh_params)))) {
-    _plain_noise = params.plain_noise;
-    _ridge_noise = params.ridge_noise;
-  }
+      : _mesh(Ref<SotaMesh>(memnew(HexMesh(hex, params.hex_mesh_params)))) {}
 
   RidgeMesh(Pentagon pentagon, RidgePentagonMeshParams params)
-      : _mesh(Ref<SotaMesh>(memnew(PentMesh(pentagon, params.pentagon_mesh_params)))) {
-    _plain_noise = params.plain_noise;
-    _ridge_noise = params.ridge_noise;
-  }
+      : _mesh(Ref<SotaMesh>(memnew(PentMesh(pentagon, params.pentagon_mesh_params)))) {}
 
   static void _bind_methods();
 
@@ -92,11 +102,11 @@ class RidgeMesh : public TileMesh {
 
   void shift_compress();
   void calculate_ridge_based_heights(std::function<double(double, double, double)> interpolation_func,
-                                     float ridge_offset, DiscreteVertexToDistance& distance_map, int divisions);
+                                     float ridge_offset, const DiscreteVertexToDistance& distance_map,
+                                     const NoiseCache& ridge_noise, int divisions);
 
-  Ref<FastNoiseLite> _plain_noise;
-  Ref<FastNoiseLite> _ridge_noise;
-  std::vector<Ridge*> _ridges;
+  // shared by all meshes of group
+  std::shared_ptr<const RidgeIndex> _ridges;
   Neighbours _neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
 
   float _min_height = std::numeric_limits<float>::max();
@@ -117,28 +127,18 @@ class RidgeMesh : public TileMesh {
   std::set<int> get_exclude_border_set() const;
 };
 
+/**
+ * @brief Creates mesh of type T. Mesh is tesselated by RidgeMesh::build(), so creation and tesselation of many meshes
+ * may be split between main and worker threads
+ */
 template <typename T>
 Ref<RidgeMesh> make_ridge_hex_mesh(Hexagon hex, RidgeHexMeshParams params) {
-  auto res = Ref<T>(memnew(T(hex, params)));
-  res->init();
-  if (params.hex_mesh_params.orientation == Orientation::Plane) {
-    res->_processor = std::make_unique<FlatMeshProcessor>(FlatMeshProcessor());
-  } else {
-    res->_processor = std::make_unique<VolumeMeshProcessor>(VolumeMeshProcessor(res->inner_mesh()->get_vertices()));
-  }
-  return res;
+  return Ref<T>(memnew(T(hex, params)));
 }
 
 template <typename T>
 Ref<RidgeMesh> make_ridge_pentagon_mesh(Pentagon pentagon, RidgePentagonMeshParams params) {
-  auto res = Ref<T>(memnew(T(pentagon, params)));
-  res->init();
-  if (params.pentagon_mesh_params.orientation == Orientation::Plane) {
-    res->_processor = std::make_unique<FlatMeshProcessor>(FlatMeshProcessor());
-  } else {
-    res->_processor = std::make_unique<VolumeMeshProcessor>(VolumeMeshProcessor(res->inner_mesh()->get_vertices()));
-  }
-  return res;
+  return Ref<T>(memnew(T(pentagon, params)));
 }
 
 }  // namespace sota
@@ -1,11 +1,15 @@
 #include "ridge_set.h"
 
-#include <array>    // for array
-#include <memory>   // for allocator_traits<>::value_type
-#include <random>   // for mt19937, uniform_int_distri...
-#include <utility>  // for pair
+#include <cstdint>        // for uint32_t
+#include <random>         // for mt19937, uniform_int_distri...
+#include <unordered_map>  // for unordered_map
+#include <unordered_set>  // for unordered_set
+#include <utility>        // for pair
+#include <vector>         // for vector
 
 #include "core/mesh.h"                    // for SotaMesh
+#include "core/tile_mesh.h"               // for TileMesh
+#include "misc/discretizer.h"             // for VertexToNormalDiscretizer
 #include "primitives/polygon.h"           // for RegularPolygon
 #include "ridge_impl/ridge_config.h"      // for RidgeConfig
 #include "ridge_impl/ridge_connection.h"  // for RidgeVertex, RidgeConnection
@@ -15,32 +19,72 @@
 
 namespace sota {
 
+namespace {
+
+uint32_t mix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+// depends only on position of tile, so it's the same in every grid containing the tile
+uint32_t position_hash(RidgeMesh* mesh) {
+  float step = mesh->inner_mesh()->get_R() / 4;
+  DiscreteVertex v = VertexToNormalDiscretizer::get_discrete_vertex(mesh->get_center(), step);
+  return mix(static_cast<uint32_t>(v.x) ^ mix(static_cast<uint32_t>(v.y) ^ mix(static_cast<uint32_t>(v.z))));
+}
+
+RidgeVertex ridge_vertex(RidgeMesh* mesh, float offset) {
+  Vector3 center = mesh->get_center();
+  Vector3 position = center + mesh->inner_mesh()->get_base_normal_direction(center) * offset;
+  return RidgeVertex(position, mesh->inner_mesh()->get_base_normal_direction(position));
+}
+
+// splits connection into pieces, inner break points are displaced sideways in turns
+std::vector<std::pair<Vector3, Vector3>> fractured_bounds(RidgeVertex lhs, RidgeVertex rhs, unsigned int pieces_num,
+                                                          std::uniform_real_distribution<float>& height_dist,
+                                                          std::mt19937& random_generator) {
+  Vector3 first_tangent = (rhs.coord - lhs.coord).cross(lhs.normal).normalized();
+  Vector3 distance = rhs.coord - lhs.coord;
+  std::vector<std::pair<Vector3, Vector3>> bounds;
+  std::vector<Vector3> displacement_xyz(pieces_num);
+  for (unsigned int i = 0; i < pieces_num; ++i) {
+    Vector3 a = lhs.coord + static_cast<float>(i) * distance / pieces_num;
+    Vector3 b = lhs.coord + static_cast<float>(i + 1) * distance / pieces_num;
+    bounds.emplace_back(a, b);
+    float randomness = height_dist(random_generator);
+    displacement_xyz[i] = randomness * ((i & 1) ? -first_tangent : first_tangent);
+  }
+  for (unsigned int i = 1; i < pieces_num; ++i) {
+    bounds[i].first += displacement_xyz[i - 1];
+    bounds[i - 1].second += displacement_xyz[i - 1];
+  }
+  return bounds;
+}
+
+}  // namespace
+
 RidgeSet::RidgeSet(RidgeConfig config) : _config(config) {}
 
 void RidgeSet::create_single(RidgeMesh* mesh, float offset) {
+  _ridges.clear();
+  add_single(mesh, offset);
+}
+
+void RidgeSet::add_single(RidgeMesh* mesh, float offset) {
   SotaMesh* m = mesh->inner_mesh();
 
   Vector3 normal = m->base().center().normalized();
   Vector3 tangent = (m->base().points()[0] - m->base().center()).normalized();
   Vector3 c = mesh->get_center() + normal * offset;
-  Vector3 start = c - tangent * 0.02;
-  Vector3 end = c + tangent * 0.02;
-
-  std::vector<std::pair<Vector3, Vector3>> bounds = {{start, end}};
-  unsigned int pieces_num = 2;
-  for (auto& [s, e] : bounds) {
-    _ridges.emplace_back(s, e);
-    Vector3 dist = e - s;
-    std::vector<Vector3> points;
-
-    for (unsigned int i = 0; i <= pieces_num; ++i) {
-      points.push_back(s + static_cast<float>(i) * dist / pieces_num);
-    }
-    _ridges.back().set_points(points);
-  }
+  _ridges.emplace_back(c - tangent * 0.02, c + tangent * 0.02);
 }
 
-void RidgeSet::create_dfs_random(std::vector<RidgeMesh*>& list, float offset, int divisions) {
+void RidgeSet::create_dfs_random(std::vector<RidgeMesh*>& list, float offset) {
+  _ridges.clear();
   constexpr int seed = 0;
   std::mt19937 random_generator(seed);
   std::uniform_int_distribution<> int_dist(0, 1000);
@@ -50,46 +94,56 @@ void RidgeSet::create_dfs_random(std::vector<RidgeMesh*>& list, float offset, in
   unsigned int fracture_num = int_dist(random_generator) % 4;
   unsigned int connection_pieces_num = fracture_num + 1;
 
-  auto tangents = [](const Vector3& lhs, const Vector3& rhs, const Vector3& lhs_normal) -> std::array<Vector3, 2> {
-    Vector3 first = (rhs - lhs).cross(lhs_normal).normalized();
-    Vector3 second = -first;
-    return {first, second};
-  };
-
   std::uniform_real_distribution<float> height_dist(_config.variation_min_bound, _config.variation_max_bound);
-  std::vector<std::pair<Vector3, Vector3>> bounds;
-  std::vector<Vector3> displacement_xyz(connection_pieces_num);
-  unsigned int connection_num = connections.size();
-  for (unsigned int k = 0; k < connection_num; ++k) {
-    auto [lhs_vertex, rhs_vertex] = connections[k].get();
-    Vector3 lhs_coord = lhs_vertex.coord;
-    Vector3 rhs_coord = rhs_vertex.coord;
-    auto ts = tangents(lhs_coord, rhs_coord, lhs_vertex.normal);
-    Vector3 distance = rhs_coord - lhs_coord;
-    for (unsigned int i = 0; i < connection_pieces_num; ++i) {
-      Vector3 a = lhs_coord + static_cast<float>(i) * distance / connection_pieces_num;
-      Vector3 b = lhs_coord + static_cast<float>(i + 1) * distance / connection_pieces_num;
-      bounds.emplace_back(a, b);
-      float randomness = height_dist(random_generator);
-      Vector3 random_vector = randomness * ((i & 1) ? ts[1] : ts[0]);
-      displacement_xyz[i] = random_vector;
+  for (RidgeConnection& connection : connections) {
+    auto [lhs_vertex, rhs_vertex] = connection.get();
+    for (auto& [start, end] :
+         fractured_bounds(lhs_vertex, rhs_vertex, connection_pieces_num, height_dist, random_generator)) {
+      _ridges.emplace_back(start, end);
+    }
+  }
+}
+
+void RidgeSet::create_local(std::vector<RidgeMesh*>& list, float offset) {
+  _ridges.clear();
+  std::unordered_map<RidgeMesh*, uint32_t> hashes;
+  for (RidgeMesh* mesh : list) {
+    hashes[mesh] = position_hash(mesh);
+  }
+
+  std::vector<std::pair<RidgeMesh*, RidgeMesh*>> connections;
+  std::unordered_set<RidgeMesh*> connected;
+  for (RidgeMesh* mesh : list) {
+    RidgeMesh* next = nullptr;
+    for (TileMesh* n : mesh->get_neighbours()) {
+      RidgeMesh* neighbour = dynamic_cast<RidgeMesh*>(n);
+      if (hashes.at(neighbour) > hashes.at(next ? next : mesh)) {
+        next = neighbour;
+      }
     }
-    for (unsigned int i = 1 + connection_pieces_num * k; i < connection_pieces_num * (k + 1); ++i) {
-      bounds[i].first += displacement_xyz[(i - 1) % connection_pieces_num];
-      bounds[i - 1].second += displacement_xyz[(i - 1) % connection_pieces_num];
+    if (next) {
+      connections.emplace_back(mesh, next);
+      connected.insert(mesh);
+      connected.insert(next);
     }
   }
 
-  unsigned int pieces_num = divisions * 2;
-  for (auto& [start, end] : bounds) {
-    _ridges.emplace_back(start, end);
-    Vector3 distance = end - start;
-    std::vector<Vector3> p;
+  for (RidgeMesh* mesh : list) {
+    if (!connected.contains(mesh)) {
+      add_single(mesh, offset);
+    }
+  }
 
-    for (unsigned int i = 0; i <= pieces_num; ++i) {
-      p.push_back(start + static_cast<float>(i) * distance / pieces_num);
+  std::uniform_int_distribution<> int_dist(0, 1000);
+  std::uniform_real_distribution<float> height_dist(_config.variation_min_bound, _config.variation_max_bound);
+  for (auto [lhs, rhs] : connections) {
+    // shape of connection is random, but the same for the same pair of tiles
+    std::mt19937 random_generator(mix(hashes.at(lhs) ^ mix(hashes.at(rhs))));
+    unsigned int pieces_num = int_dist(random_generator) % 4 + 1;
+    for (auto& [start, end] : fractured_bounds(ridge_vertex(lhs, offset), ridge_vertex(rhs, offset), pieces_num,
+                                               height_dist, random_generator)) {
+      _ridges.emplace_back(start, end);
     }
-    _ridges.back().set_points(p);
   }
 }
 
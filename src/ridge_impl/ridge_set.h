@@ -20,13 +20,23 @@ class RidgeSet {
   RidgeSet& operator=(const RidgeSet& other) = default;
   RidgeSet& operator=(RidgeSet&& other) = default;
 
-  void create_dfs_random(std::vector<RidgeMesh*>& list, float offset, int divisions);
+  void create_dfs_random(std::vector<RidgeMesh*>& list, float offset);
   void create_single(RidgeMesh* mesh, float offset);
+
+  /**
+   * @brief Connects every tile to the neighbour of the group with the highest hash of position, if it's higher than
+   * hash of tile itself. Tiles without connections get single short ridge. Unlike create_dfs_random() ridges near tile
+   * depend only on tiles at most two rings away, so overlapping parts of neighbouring grids get the same ridges
+   */
+  void create_local(std::vector<RidgeMesh*>& list, float offset);
   std::vector<Ridge>* ridges() { return &_ridges; }
+  void set_config(RidgeConfig config) { _config = config; }
 
  private:
   std::vector<Ridge> _ridges;
   RidgeConfig _config;
+
+  void add_single(RidgeMesh* mesh, float offset);
 };
 
 }  // namespace sota
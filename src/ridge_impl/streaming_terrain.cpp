@@ -0,0 +1,253 @@
+#include "ridge_impl/streaming_terrain.h"
+
+#include <algorithm>  // for max
+#include <cstdlib>    // for abs
+#include <memory>     // for unique_ptr
+#include <optional>   // for optional
+#include <utility>    // for move, pair
+#include <vector>     // for vector, erase_if
+
+#include "algo/dsu.h"               // for DSU
+#include "core/hex_grid.h"          // for TilesLayout
+#include "misc/cube_coordinates.h"  // for OffsetCoordinates, pixelToCube, cubeToOffset
+#include "misc/tile.h"              // for BiomeTile, Tile
+#include "misc/types.h"             // for Biome, ClipOptions, Neighbours
+#include "ridge_impl/ridge_mesh.h"  // for RidgeMesh
+#include "tal/camera.h"             // for Camera3D, Viewport
+#include "tal/godot_core.h"         // for D_METHOD, ClassDB, memnew, StringName
+#include "tal/vector3.h"            // for Vector3
+#include "tal/vector3i.h"           // for Vector3i
+
+namespace sota {
+
+namespace {
+
+// rounds towards negative infinity, so regions of negative rows and columns have the same size
+int floor_div(int a, int b) { return a / b - (a % b < 0 ? 1 : 0); }
+
+}  // namespace
+
+// TerrainRegion definitions
+TerrainRegion::TerrainRegion(int first_row, int first_col, int size)
+    : _first_row(first_row), _first_col(first_col), _size(size) {
+  _seamless = true;
+}
+
+void TerrainRegion::_bind_methods() {}
+
+void TerrainRegion::init_col_row_layout() {
+  _col_row_layout.clear();
+  for (int i = 0; i < window_size(); ++i) {
+    _col_row_layout.push_back({});
+    for (int j = 0; j < window_size(); ++j) {
+      _col_row_layout.back().push_back(Vector3i(_first_row - MARGIN + i, 0, _first_col - MARGIN + j));
+    }
+  }
+}
+
+int TerrainRegion::calculate_id(int row, int col) const {
+  return (row - _first_row + MARGIN) * window_size() + (col - _first_col + MARGIN);
+}
+
+BiomeGroups TerrainRegion::collect_biome_groups(Biome b) {
+  int width = window_size();
+  algo::DSU<RidgeMesh*> u(width, width);
+
+  for (auto& row : _tiles_layout) {
+    for (auto& tile_ptr : row) {
+      BiomeTile* tile = dynamic_cast<BiomeTile*>(tile_ptr);
+      if (tile->biome() != b) {
+        continue;
+      }
+      OffsetCoordinates coords = tile->get_offset_coords();
+      RidgeMesh* mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
+      u.push(calculate_id(coords.row, coords.col), mesh);
+      // tiles which are not pushed yet are united when their turn comes
+      for (Tile* neighbour : _tile_index.neighbours(tile->get_cube_coords())) {
+        if (neighbour) {
+          OffsetCoordinates n = neighbour->get_offset_coords();
+          u.make_union(calculate_id(coords.row, coords.col), calculate_id(n.row, n.col));
+        }
+      }
+    }
+  }
+  return u.groups();
+}
+
+ClipOptions TerrainRegion::get_clip_options(int row, int col) const {
+  return {.left = false, .right = false, .up = false, .down = false};
+}
+
+bool TerrainRegion::in_region(OffsetCoordinates coords) const {
+  return _first_row <= coords.row && coords.row < _first_row + _size && _first_col <= coords.col &&
+         coords.col < _first_col + _size;
+}
+
+void TerrainRegion::finalize_tiles() {
+  TilesLayout region_tiles;
+  for (std::vector<Tile*>& row : _tiles_layout) {
+    std::vector<Tile*> region_row;
+    for (Tile* tile : row) {
+      if (in_region(tile->get_offset_coords())) {
+        region_row.push_back(tile);
+      }
+    }
+    if (!region_row.empty()) {
+      region_tiles.push_back(std::move(region_row));
+    }
+  }
+  _tiles_layout = std::move(region_tiles);
+  // margin tiles are deleted before publish(), so they never get nodes
+  std::erase_if(_tiles, [this](const std::unique_ptr<Tile>& tile) { return !in_region(tile->get_offset_coords()); });
+  index_tiles();
+
+  // neighbours, ridges and distances are needed only for calculation of heights and may refer to deleted tiles
+  Neighbours no_neighbours = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+  for (auto& row : _tiles_layout) {
+    for (Tile* tile : row) {
+      dynamic_cast<BiomeTile*>(tile)->set_neighbours(no_neighbours);
+      RidgeMesh* mesh = dynamic_cast<RidgeMesh*>(tile->mesh().ptr());
+      mesh->set_neighbours(no_neighbours);
+      mesh->set_ridges({});
+    }
+  }
+  _mountain_groups.clear();
+  _water_groups.clear();
+  _plain_groups.clear();
+  _hill_groups.clear();
+  _distance_map.clear();
+}
+
+// StreamingTerrain definitions
+void StreamingTerrain::_bind_methods() {
+  ClassDB::bind_method(D_METHOD("get_region_size"), &StreamingTerrain::get_region_size);
+  ClassDB::bind_method(D_METHOD("set_region_size", "p_region_size"), &StreamingTerrain::set_region_size);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "region_size"), "set_region_size", "get_region_size");
+
+  ClassDB::bind_method(D_METHOD("get_view_distance"), &StreamingTerrain::get_view_distance);
+  ClassDB::bind_method(D_METHOD("set_view_distance", "p_view_distance"), &StreamingTerrain::set_view_distance);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "view_distance"), "set_view_distance", "get_view_distance");
+}
+
+void StreamingTerrain::set_region_size(const int p_region_size) {
+  if (queue_if_generating("set_region_size", p_region_size)) {
+    return;
+  }
+  _region_size = p_region_size > 1 ? p_region_size : 1;
+  _regions_outdated = true;
+}
+
+void StreamingTerrain::set_view_distance(const int p_view_distance) {
+  if (queue_if_generating("set_view_distance", p_view_distance)) {
+    return;
+  }
+  // regions out of view are deleted by next update
+  _view_distance = p_view_distance > 0 ? p_view_distance : 0;
+}
+
+int StreamingTerrain::get_region_size() const { return _region_size; }
+int StreamingTerrain::get_view_distance() const { return _view_distance; }
+
+void StreamingTerrain::generate_async() {
+  // regions are always generated on background thread
+  _regions_outdated = true;
+}
+
+void StreamingTerrain::init_col_row_layout() {
+  // terrain has no tiles of its own
+  _col_row_layout.clear();
+}
+
+int StreamingTerrain::calculate_id(int row, int col) const { return 0; }
+
+BiomeGroups StreamingTerrain::collect_biome_groups(Biome b) { return {}; }
+
+ClipOptions StreamingTerrain::get_clip_options(int row, int col) const {
+  return {.left = false, .right = false, .up = false, .down = false};
+}
+
+void StreamingTerrain::regenerate_stages(int stages) {
+  // regions copy settings on creation, so all of them are generated again
+  _regions_outdated = true;
+}
+
+void StreamingTerrain::_validate_property(PropertyInfo& p_property) const {
+  if (p_property.name == StringName("chunk_size") || p_property.name == StringName("analytic_picking") ||
+      p_property.name == StringName("lod_levels") || p_property.name == StringName("lod_distance")) {
+    p_property.usage = PROPERTY_USAGE_NO_EDITOR;
+  }
+}
+
+void StreamingTerrain::_notification(int p_what) {
+  if (p_what == NOTIFICATION_READY) {
+    set_process(true);
+  } else if (p_what == NOTIFICATION_PROCESS) {
+    update_regions();
+  }
+}
+
+void StreamingTerrain::update_regions() {
+  if (_loading && _loading->is_generating()) {
+    // one region is generated at a time
+    return;
+  }
+  _loading = nullptr;
+  if (_regions_outdated) {
+    _regions_outdated = false;
+    for (auto& [coords, region] : _regions) {
+      delete_region(region);
+    }
+    _regions.clear();
+  }
+
+  auto [center_row, center_col] = camera_region();
+  // regions are deleted one region further than they are generated, so they aren't deleted and generated again when
+  // camera moves back and forth across border of regions
+  for (auto it = _regions.begin(); it != _regions.end();) {
+    auto [row, col] = it->first;
+    if (std::max(std::abs(row - center_row), std::abs(col - center_col)) > _view_distance + 1) {
+      delete_region(it->second);
+      it = _regions.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::optional<std::pair<int, int>> nearest;
+  int nearest_distance = 0;
+  for (int row = center_row - _view_distance; row <= center_row + _view_distance; ++row) {
+    for (int col = center_col - _view_distance; col <= center_col + _view_distance; ++col) {
+      int distance = (row - center_row) * (row - center_row) + (col - center_col) * (col - center_col);
+      if (!_regions.contains({row, col}) && (!nearest || distance < nearest_distance)) {
+        nearest = {row, col};
+        nearest_distance = distance;
+      }
+    }
+  }
+  if (!nearest) {
+    return;
+  }
+
+  auto [row, col] = *nearest;
+  TerrainRegion* region = memnew(TerrainRegion(row * _region_size, col * _region_size, _region_size));
+  region->copy_settings(*this);
+  add_child(region);
+  _regions[*nearest] = region;
+  _loading = region;
+  region->generate_async();
+}
+
+std::pair<int, int> StreamingTerrain::camera_region() const {
+  Viewport* viewport = get_viewport();
+  Camera3D* camera = viewport ? viewport->get_camera_3d() : nullptr;
+  Vector3 position = camera ? get_global_transform().affine_inverse().xform(camera->get_global_position()) : Vector3();
+  OffsetCoordinates tile = cubeToOffset(pixelToCube(position.x, position.z, _diameter / 2));
+  return {floor_div(tile.row, _region_size), floor_div(tile.col, _region_size)};
+}
+
+void StreamingTerrain::delete_region(TerrainRegion* region) {
+  remove_child(region);
+  region->queue_free();
+}
+
+}  // namespace sota
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <map>      // for map
+#include <utility>  // for pair
+
+#include "misc/cube_coordinates.h"      // for OffsetCoordinates
+#include "misc/types.h"                 // for Biome, ClipOptions
+#include "ridge_impl/ridge_group.h"     // for BiomeGroups
+#include "ridge_impl/ridge_hex_grid.h"  // for RidgeHexGrid
+#include "tal/godot_core.h"             // for PropertyInfo
+
+namespace sota {
+
+/**
+ * @brief Seamless grid of one region of StreamingTerrain. Margin of tiles around region is generated as well, so tiles
+ * of region have the same neighbourhood as in unbounded grid. Tiles of margin are deleted once heights are final
+ */
+class TerrainRegion : public RidgeHexGrid {
+  GDCLASS(TerrainRegion, RidgeHexGrid)
+
+ public:
+  TerrainRegion() = default;  // existence is 'must' for Godot
+  TerrainRegion(int first_row, int first_col, int size);
+
+  void init_col_row_layout() override;
+  int calculate_id(int row, int col) const override;
+  BiomeGroups collect_biome_groups(Biome b) override;
+  ClipOptions get_clip_options(int row, int col) const override;
+
+ protected:
+  static void _bind_methods();
+  void finalize_tiles() override;
+
+ private:
+  // ridges and distances to borders near tile depend on tiles up to four rings away
+  static constexpr int MARGIN = 5;
+
+  int _first_row{0};
+  int _first_col{0};
+  int _size{1};
+
+  int window_size() const { return _size + 2 * MARGIN; }
+  bool in_region(OffsetCoordinates coords) const;
+};
+
+/**
+ * @brief Unbounded terrain streamed around camera of viewport. Terrain is split into square regions of tiles, which
+ * are generated one at a time on background thread, nearest to camera first, and deleted when they are far from
+ * camera. Regions are seamless grids, so biomes, ridges and heights are continuous across their borders
+ *
+ * Settings of generation are the same as of RidgeHexGrid, any change of them generates regions again. Terrain has no
+ * tiles of its own, so properties of chunks, levels of detail and picking are hidden and materials aren't created
+ */
+class StreamingTerrain : public RidgeHexGrid {
+  GDCLASS(StreamingTerrain, RidgeHexGrid)
+
+ public:
+  /**
+   * @brief Property shared with Godot inspector. Number of rows and columns of tiles in one region
+   */
+  void set_region_size(int p_region_size);
+  int get_region_size() const;
+
+  /**
+   * @brief Property shared with Godot inspector. Regions at most this number of regions away from region of camera
+   * are generated
+   */
+  void set_view_distance(int p_view_distance);
+  int get_view_distance() const;
+
+  void generate_async() override;
+
+  void init_col_row_layout() override;
+  int calculate_id(int row, int col) const override;
+  BiomeGroups collect_biome_groups(Biome b) override;
+  ClipOptions get_clip_options(int row, int col) const override;
+
+ protected:
+  static void _bind_methods();
+  void _notification(int p_what);
+  void _validate_property(PropertyInfo& p_property) const;
+  void init_materials() override {}
+  void publish() override {}
+  void regenerate_stages(int stages) override;
+
+ private:
+  int _region_size{16};
+  int _view_distance{2};
+
+  // regions by their row and column
+  std::map<std::pair<int, int>, TerrainRegion*> _regions;
+  TerrainRegion* _loading{nullptr};
+  bool _regions_outdated{false};
+
+  void update_regions();
+  std::pair<int, int> camera_region() const;
+  void delete_region(TerrainRegion* region);
+};
+
+}  // namespace sota
@@ -7,8 +7,9 @@ namespace sota {
 // TODO globals
 constexpr float bottom_y_offset = 0.5;
 
-void WaterMesh::calculate_final_heights(DiscreteVertexToDistance& distance_map, float diameter, int divisions) {
-  calculate_ridge_based_heights(cosrp, bottom_y_offset, distance_map, divisions);
+void WaterMesh::calculate_final_heights(const DiscreteVertexToDistance& distance_map, const NoiseCache& ridge_noise,
+                                        float diameter, int divisions) {
+  calculate_ridge_based_heights(cosrp, bottom_y_offset, distance_map, ridge_noise, divisions);
 }
 
 }  // namespace sota
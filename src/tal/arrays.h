@@ -2,6 +2,7 @@
 
 #ifdef SOTA_GDEXTENSION
 #include "godot_cpp/variant/array.hpp"
+#include "godot_cpp/variant/dictionary.hpp"
 #include "godot_cpp/variant/packed_byte_array.hpp"
 #include "godot_cpp/variant/packed_color_array.hpp"
 #include "godot_cpp/variant/packed_float32_array.hpp"
@@ -13,6 +14,7 @@
 template <typename T>
 using TypedArray = godot::TypedArray<T>;
 using Array = godot::Array;
+using Dictionary = godot::Dictionary;
 
 using Vector2Array = godot::PackedVector2Array;
 using Vector3Array = godot::PackedVector3Array;
@@ -22,13 +24,16 @@ using WeightsArray = godot::PackedFloat32Array;
 using ColorsArray = godot::PackedColorArray;
 using ByteArray = godot::PackedByteArray;
 using IntArray = godot::PackedInt32Array;
+using FloatArray = godot::PackedFloat32Array;
 #else
 
 #include "core/variant/array.h"
+#include "core/variant/dictionary.h"
 #include "core/variant/typed_array.h"
 #include "core/variant/variant.h"
 
 using Array = Array;
+using Dictionary = Dictionary;
 
 using Vector2Array = PackedVector2Array;
 using Vector3Array = PackedVector3Array;
@@ -38,6 +43,7 @@ using WeightsArray = PackedFloat32Array;
 using ColorsArray = PackedColorArray;
 using ByteArray = PackedByteArray;
 using IntArray = PackedInt32Array;
+using FloatArray = PackedFloat32Array;
 
 #endif
 
@@ -1,9 +1,12 @@
-
 #pragma once
 
 #ifdef SOTA_GDEXTENSION
 #include "godot_cpp/classes/camera3d.hpp"
+#include "godot_cpp/classes/viewport.hpp"
 
 using Camera3D = godot::Camera3D;
+using Viewport = godot::Viewport;
 #else
+#include "scene/3d/camera_3d.h"
+#include "scene/main/viewport.h"
 #endif
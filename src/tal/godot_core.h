@@ -9,6 +9,7 @@
 #include "godot_cpp/core/class_db.hpp"
 #include "godot_cpp/core/property_info.hpp"
 #include "godot_cpp/godot.hpp"
+#include "godot_cpp/variant/string_name.hpp"
 #include "godot_cpp/variant/utility_functions.hpp"
 #include "godot_cpp/variant/variant.hpp"
 #include "godot_cpp/core/memory.hpp"
@@ -17,9 +18,13 @@ using ClassDB = godot::ClassDB;
 using UtilityFunctions = godot::UtilityFunctions;
 using Variant = godot::Variant;
 using PropertyInfo = godot::PropertyInfo;
+using StringName = godot::StringName;
 using ModuleInitializationLevel = godot::ModuleInitializationLevel;
 using GDExtensionBinding = godot::GDExtensionBinding;
 constexpr godot::PropertyHint PROPERTY_HINT_RESOURCE_TYPE = godot::PropertyHint::PROPERTY_HINT_RESOURCE_TYPE;
+constexpr godot::PropertyHint PROPERTY_HINT_FLAGS = godot::PropertyHint::PROPERTY_HINT_FLAGS;
+constexpr godot::PropertyHint PROPERTY_HINT_RANGE = godot::PropertyHint::PROPERTY_HINT_RANGE;
+constexpr godot::PropertyUsageFlags PROPERTY_USAGE_NO_EDITOR = godot::PropertyUsageFlags::PROPERTY_USAGE_NO_EDITOR;
 constexpr godot::ModuleInitializationLevel MODULE_INITIALIZATION_LEVEL_SCENE =
     godot::ModuleInitializationLevel::MODULE_INITIALIZATION_LEVEL_SCENE;
 
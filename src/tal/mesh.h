@@ -1,12 +1,14 @@
 #pragma once
 
 #ifdef SOTA_GDEXTENSION
+#include "godot_cpp/classes/array_mesh.hpp"
 #include "godot_cpp/classes/collision_shape3d.hpp"
 #include "godot_cpp/classes/mesh_instance3d.hpp"
 #include "godot_cpp/classes/primitive_mesh.hpp"
 #include "godot_cpp/classes/sphere_shape3d.hpp"
 #include "godot_cpp/classes/static_body3d.hpp"
 
+using ArrayMesh = godot::ArrayMesh;
 using PrimitiveMesh = godot::PrimitiveMesh;
 using MeshInstance3D = godot::MeshInstance3D;
 using StaticBody3D = godot::StaticBody3D;
@@ -20,7 +22,9 @@ using SphereShape3D = godot::SphereShape3D;
 #include "scene/3d/physics/static_body_3d.h"
 #include "scene/resources/3d/primitive_meshes.h"
 #include "scene/resources/3d/sphere_shape_3d.h"
+#include "scene/resources/mesh.h"
 
+using ArrayMesh = ArrayMesh;
 using PrimitiveMesh = PrimitiveMesh;
 using MeshInstance3D = MeshInstance3D;
 using StaticBody3D = StaticBody3D;
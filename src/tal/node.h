@@ -3,13 +3,17 @@
 #ifdef SOTA_GDEXTENSION
 #include "godot_cpp/classes/node.hpp"
 #include "godot_cpp/classes/node3d.hpp"
+#include "godot_cpp/variant/node_path.hpp"
 
 using Node3D = godot::Node3D;
 using Node = godot::Node;
+using NodePath = godot::NodePath;
 #else
+#include "core/string/node_path.h"
 #include "scene/3d/node_3d.h"
 #include "scene/main/node.h"
 
 using Node3D = Node3D;
 using Node = Node;
+using NodePath = NodePath;
 #endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#ifdef SOTA_GDEXTENSION
+#include "godot_cpp/classes/rendering_server.hpp"
+#include "godot_cpp/variant/aabb.hpp"
+#include "godot_cpp/variant/rid.hpp"
+
+using RenderingServer = godot::RenderingServer;
+using AABB = godot::AABB;
+using RID = godot::RID;
+
+#else
+
+#include "core/math/aabb.h"
+#include "core/templates/rid.h"
+#include "servers/rendering_server.h"
+
+using RenderingServer = RenderingServer;
+using AABB = AABB;
+using RID = RID;
+
+#endif
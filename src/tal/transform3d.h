@@ -0,0 +1,11 @@
+#pragma once
+
+#ifdef SOTA_GDEXTENSION
+#include "godot_cpp/variant/transform3d.hpp"
+
+using Transform3D = godot::Transform3D;
+#else
+#include "core/math/transform_3d.h"
+
+using Transform3D = Transform3D;
+#endif
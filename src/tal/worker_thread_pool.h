@@ -0,0 +1,10 @@
+#pragma once
+
+#ifdef SOTA_GDEXTENSION
+#include "godot_cpp/classes/worker_thread_pool.hpp"
+
+using WorkerThreadPool = godot::WorkerThreadPool;
+
+#else
+#include "core/object/worker_thread_pool.h"
+#endif